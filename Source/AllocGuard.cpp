@@ -0,0 +1,128 @@
+#include "AllocGuard.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+
+// Number of guard scopes active on each thread:
+static thread_local int guardDepth = 0;
+// Total heap allocations made by all threads:
+static std::atomic<uint64_t> allocationCount(0);
+
+
+// Forbids heap allocation on the current thread while the Scope exists.
+AllocGuard::Scope::Scope()
+{
+    guardDepth++;
+}
+
+
+// Ends the guard scope.
+AllocGuard::Scope::~Scope()
+{
+    guardDepth--;
+}
+
+
+// Suspends all guard scopes on the current thread while the Exemption exists.
+AllocGuard::Exemption::Exemption() : savedDepth(guardDepth)
+{
+    guardDepth = 0;
+}
+
+
+// Restores suspended guard scopes.
+AllocGuard::Exemption::~Exemption()
+{
+    guardDepth = savedDepth;
+}
+
+
+// Gets the number of heap allocations made by all threads since the program
+// started.
+uint64_t AllocGuard::getAllocationCount()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+
+#if ALLOC_CHECK
+// Counts a heap allocation, aborting if it was made within a guard scope.
+static void checkAllocation(const size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (guardDepth > 0)
+    {
+        // Formatting must not allocate, so print with a fixed buffer:
+        char message [128];
+        const int length = snprintf(message, sizeof(message),
+                "AllocGuard: %zu byte heap allocation in a steady-state "
+                "code path!\n", size);
+        if (length > 0)
+        {
+            const ssize_t written = write(STDERR_FILENO, message, length);
+            (void) written;
+        }
+        abort();
+    }
+}
+
+
+// Allocates memory with malloc, throwing if allocation fails.
+static void* allocate(const size_t size)
+{
+    checkAllocation(size);
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+
+// Replacement global allocation functions:
+
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    checkAllocation(size);
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    checkAllocation(size);
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file  AllocGuard.h
+ *
+ * @brief  Checks that steady-state code paths never allocate heap memory.
+ *
+ *  Code paths that run for every input event or frame are marked with
+ * ALLOC_GUARD_SCOPE. When the project is built with ALLOC_CHECK=1, global
+ * operator new is replaced, and any heap allocation made while a guard scope
+ * is active prints the allocation size and aborts the program, so the
+ * allocating call can be found in a debugger or core dump. In normal builds,
+ * ALLOC_GUARD_SCOPE and ALLOC_GUARD_ALLOW do nothing.
+ *
+ *  Rare events that are allowed to allocate, like restarting a daemon, are
+ * marked with ALLOC_GUARD_ALLOW, which suspends checking until the end of its
+ * scope.
+ */
+
+#pragma once
+#include <cstdint>
+
+#if ALLOC_CHECK
+#   define ALLOC_GUARD_SCOPE AllocGuard::Scope allocGuardScope;
+#   define ALLOC_GUARD_ALLOW AllocGuard::Exemption allocGuardExemption;
+#else
+#   define ALLOC_GUARD_SCOPE
+#   define ALLOC_GUARD_ALLOW
+#endif
+
+namespace AllocGuard
+{
+    /**
+     * @brief  Forbids heap allocation on the current thread while it exists.
+     *         Scopes may be nested.
+     */
+    class Scope
+    {
+    public:
+        Scope();
+
+        ~Scope();
+    };
+
+    /**
+     * @brief  Allows heap allocation on the current thread while it exists,
+     *         even within a Scope.
+     */
+    class Exemption
+    {
+    public:
+        Exemption();
+
+        ~Exemption();
+
+    private:
+        // The number of guard scopes active when the exemption was created:
+        int savedDepth;
+    };
+
+    /**
+     * @brief  Gets the number of heap allocations made by all threads since
+     *         the program started. This is always zero unless the project is
+     *         built with ALLOC_CHECK=1.
+     *
+     * @return  The total allocation count.
+     */
+    uint64_t getAllocationCount();
+}
@@ -1,13 +1,21 @@
 #include "Coordinator.h"
+#include "AllocGuard.h"
 #include "Debug.h"
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 
+#ifdef DEBUG
+// Print the full class name before all debug output:
+static const constexpr char* messagePrefix = "Coordinator::";
+#endif
+
 
 // Initializes the Coordinator, saving references to the objects the
 // coordinator coordinates.
 Coordinator::Coordinator(CursorPainter& painter, CursorTracker& tracker) :
-        painter(painter), tracker(tracker), loopShouldContinue(true) { }
+        painter(painter), tracker(tracker), loopShouldContinue(true),
+        requestedShape(CursorAtlas::Shape::arrow), buttonState(0) { }
 
 
 // Ensures the update thread has stopped before the Coordinator is destroyed.
@@ -17,51 +25,167 @@ Coordinator::~Coordinator()
     {
         stopUpdateLoop();
         updateThread.join();
+        DBG(messagePrefix << __func__ << ": Update loop jitter: "
+                << updateJitter.getSampleCount() << " samples, mean "
+                << updateJitter.getMeanNanoseconds() / 1000 << "us, max "
+                << updateJitter.getMaxNanoseconds() / 1000 << "us");
     }
 }
 
+// Sets an object that will publish the cursor position and button state to
+// other processes.
+void Coordinator::setPublisher(CursorPublisher* publisher)
+{
+    this->publisher = publisher;
+}
+
+
 // If its not already running, starts the cursor update loop in a new thread.
-void Coordinator::startUpdateLoop(const int updatesPerSecond)
+void Coordinator::startUpdateLoop(const int maxUpdatesPerSecond,
+        const RealTime::ThreadConfig threadConfig)
 {
     if (! updateThread.joinable())
     {
         loopShouldContinue.store(true);
-        updateThread = std::thread(cursorUpdateLoop, updatesPerSecond, this);
+        updateThread = std::thread(cursorUpdateLoop, maxUpdatesPerSecond,
+                threadConfig, this);
     }
 }
 
 // Signals to the Coordinator that the cursor update loop should stop.
 void Coordinator::stopUpdateLoop()
 {
+    std::lock_guard<std::mutex> lock(updateLock);
     loopShouldContinue.store(false);
+    updateCondition.notify_one();
 }
 
 
-// Continually updates the cursor position at a specific frequency, running
-// within another thread.
-void Coordinator::cursorUpdateLoop
-(const int updatesPerSecond, Coordinator* coordinator)
+// Gets statistics on how late the update loop wakes up compared to its
+// scheduled update times.
+const RealTime::JitterStats& Coordinator::getUpdateJitter() const
 {
+    return updateJitter;
+}
+
+
+// Adds the Coordinator's performance counters to a stats file.
+void Coordinator::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter("frames_sent", framesSent);
+    statsFile.addCounter("frames_skipped", framesSkipped);
+    statsFile.addCounter("key_events", keyEvents);
+    statsFile.addCounter("shapes_sent", shapesSent);
+    statsFile.addJitter("update_jitter", updateJitter);
+}
+
+
+// Continually updates the cursor position and shape, running within another
+// thread.
+void Coordinator::cursorUpdateLoop(const int maxUpdatesPerSecond,
+        const RealTime::ThreadConfig threadConfig, Coordinator* coordinator)
+{
+    RealTime::configureThread(threadConfig, "cursor update thread");
     using namespace std::chrono;
     using HighResClock = high_resolution_clock;
     using TimePoint = time_point<HighResClock, nanoseconds>;
-    const nanoseconds loopDuration(1000000000 / updatesPerSecond);
-    TimePoint lastUpdateTime(HighResClock::now());
+    const nanoseconds minLoopDuration(1000000000 / maxUpdatesPerSecond);
+    // Tracks the last position sent, so unchanged positions are skipped:
+    CursorTracker::Point lastSent = { 0, 0 };
+    bool sentFirstUpdate = false;
+    CursorAtlas::Shape lastShape = CursorAtlas::Shape::arrow;
+    // Tracks the last state published, so unchanged states are skipped:
+    CursorTracker::Point lastPublished = { 0, 0 };
+    uint32_t lastButtons = 0;
+    bool publishedFirstUpdate = false;
+    const auto shouldWake = [coordinator]()
+    {
+        return coordinator->inputChanged
+                || ! coordinator->loopShouldContinue.load();
+    };
     while(coordinator->loopShouldContinue.load())
     {
+        ALLOC_GUARD_SCOPE
         const TimePoint loopStart = HighResClock::now();
-        const nanoseconds timePassed = loopStart - lastUpdateTime;
-        if (timePassed < loopDuration)
+        const CursorAtlas::Shape shape = coordinator->requestedShape.load();
+        if (shape != lastShape && coordinator->painter.setCursorShape(shape))
+        {
+            lastShape = shape;
+            coordinator->shapesSent.add();
+        }
+        CursorTracker::Point cursorPos = coordinator->tracker.getCursorPos();
+        if (! sentFirstUpdate || cursorPos.x != lastSent.x
+                || cursorPos.y != lastSent.y)
+        {
+            if (coordinator->painter.drawCursor(cursorPos.x, cursorPos.y))
+            {
+                lastSent = cursorPos;
+                sentFirstUpdate = true;
+                coordinator->framesSent.add();
+            }
+        }
+        else
+        {
+            coordinator->framesSkipped.add();
+        }
+        const uint32_t buttons = coordinator->buttonState.load();
+        if (coordinator->publisher != nullptr && (! publishedFirstUpdate
+                || cursorPos.x != lastPublished.x
+                || cursorPos.y != lastPublished.y || buttons != lastButtons))
+        {
+            coordinator->publisher->publish(cursorPos.x, cursorPos.y, buttons);
+            lastPublished = cursorPos;
+            lastButtons = buttons;
+            publishedFirstUpdate = true;
+        }
+
+        // Wait about as long as the cursor takes to move a single pixel, or
+        // until the next input change if the cursor isn't moving. If the
+        // painter couldn't accept the last position or shape, keep waking at
+        // the minimum loop duration to send it again:
+        const bool painterUpdated = sentFirstUpdate
+                && cursorPos.x == lastSent.x && cursorPos.y == lastSent.y
+                && shape == lastShape;
+        const double speed = coordinator->tracker.getCursorSpeed();
+        std::unique_lock<std::mutex> lock(coordinator->updateLock);
+        if (speed <= 0 && painterUpdated)
+        {
+            coordinator->updateCondition.wait(lock, shouldWake);
+        }
+        else
+        {
+            nanoseconds loopDuration = minLoopDuration;
+            if (speed > 0)
+            {
+                // Speed is measured in pixels per millisecond:
+                const nanoseconds pixelDuration(
+                        static_cast<nanoseconds::rep>(1000000 / speed));
+                loopDuration = std::max(loopDuration, pixelDuration);
+            }
+            const TimePoint wakeTime = loopStart + loopDuration;
+            if (! coordinator->updateCondition.wait_until(lock, wakeTime,
+                    shouldWake))
+            {
+                coordinator->updateJitter.addSample(
+                        HighResClock::now() - wakeTime);
+            }
+        }
+        coordinator->inputChanged = false;
+        lock.unlock();
+
+        // Input changes may cut the wait short, but never below the minimum
+        // loop duration:
+        const nanoseconds timePassed = HighResClock::now() - loopStart;
+        if (timePassed < minLoopDuration)
         {
-            const nanoseconds sleepTime = loopDuration - timePassed;
+            const nanoseconds sleepTime = minLoopDuration - timePassed;
             struct timespec sleepTimer;
             sleepTimer.tv_sec = 0;
             sleepTimer.tv_nsec = sleepTime.count();
             nanosleep(&sleepTimer, nullptr);
+            coordinator->updateJitter.addSample(
+                    HighResClock::now() - (loopStart + minLoopDuration));
         }
-        CursorTracker::Point cursorPos = coordinator->tracker.getCursorPos();
-        coordinator->painter.drawCursor(cursorPos.x, cursorPos.y);
-        lastUpdateTime = HighResClock::now();
     }
 }
 
@@ -70,6 +194,34 @@ void Coordinator::cursorUpdateLoop
 void Coordinator::handleKeyEvent
 (const KeyListener::Key key, const KeyDaemon::EventType actionType)
 {
+    ALLOC_GUARD_SCOPE
+    updateTracker(key, actionType);
+    signalInputChanged();
+}
+
+
+// Receives a group of simultaneous keyboard input events, passing them all on
+// to the cursor tracker before waking the update loop once.
+void Coordinator::handleKeyEvents
+(const KeyListener::KeyEvent* events, const size_t count)
+{
+    ALLOC_GUARD_SCOPE
+    for (size_t i = 0; i < count; i++)
+    {
+        updateTracker(events[i].key, events[i].actionType);
+    }
+    signalInputChanged();
+}
+
+
+// Passes a keyboard input event on to the cursor tracker without waking the
+// update loop.
+void Coordinator::updateTracker
+(const KeyListener::Key key, const KeyDaemon::EventType actionType)
+{
+    keyEvents.add();
+    const bool keyIsDown = (actionType == KeyDaemon::EventType::pressed)
+            || (actionType == KeyDaemon::EventType::held);
     CursorTracker::DirectionKey directionKey;
     switch (key)
     {
@@ -85,10 +237,40 @@ void Coordinator::handleKeyEvent
         case KeyListener::Key::right:
             directionKey = CursorTracker::DirectionKey::right;
             break;
+        case KeyListener::Key::leftClick:
+            // Show the drag cursor while the left-click key is held:
+            requestedShape.store(keyIsDown ? CursorAtlas::Shape::drag
+                    : CursorAtlas::Shape::arrow);
+            updateButtonState(SharedCursor::leftButton, keyIsDown);
+            return;
+        case KeyListener::Key::rightClick:
+            updateButtonState(SharedCursor::rightButton, keyIsDown);
+            return;
         default:
             return; // TODO: handle keys other than navigation keys!
     }
-    const bool keyIsDown = (actionType == KeyDaemon::EventType::pressed)
-            || (actionType == KeyDaemon::EventType::held);
     tracker.updateKeyState(directionKey, keyIsDown);
 }
+
+
+// Sets or clears a button's bit in the button state.
+void Coordinator::updateButtonState(const uint32_t button, const bool isDown)
+{
+    if (isDown)
+    {
+        buttonState.fetch_or(button);
+    }
+    else
+    {
+        buttonState.fetch_and(~button);
+    }
+}
+
+
+// Wakes the update loop after key input changes.
+void Coordinator::signalInputChanged()
+{
+    std::lock_guard<std::mutex> lock(updateLock);
+    inputChanged = true;
+    updateCondition.notify_one();
+}
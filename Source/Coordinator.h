@@ -9,7 +9,12 @@
 #include "KeyListener.h"
 #include "CursorPainter.h"
 #include "CursorTracker.h"
+#include "CursorPublisher.h"
+#include "RealTime.h"
+#include "Stats.h"
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 class Coordinator : public KeyListener::InputHandler
@@ -33,14 +38,31 @@ public:
      */
     virtual ~Coordinator();
 
+    /**
+     * @brief  Sets an object that will publish the cursor position and button
+     *         state to other processes. This must be called before starting
+     *         the update loop.
+     *
+     * @param publisher  The object that will publish cursor updates, or
+     *                   nullptr to stop publishing.
+     */
+    void setPublisher(CursorPublisher* publisher);
+
     /**
      * @brief  If its not already running, starts the cursor update loop in a
      *         new thread.
      *
-     * @param updatesPerSecond  Number of times per second that the Coordinator
-     *                          should send cursor updates.
+     * @param maxUpdatesPerSecond  Maximum number of times per second that the
+     *                             Coordinator should send cursor updates.
+     *                             This should usually match the display
+     *                             refresh rate.
+     *
+     * @param threadConfig         Scheduling options to apply to the update
+     *                             thread.
      */
-    void startUpdateLoop(const int updatesPerSecond);
+    void startUpdateLoop(const int maxUpdatesPerSecond,
+            const RealTime::ThreadConfig threadConfig
+            = RealTime::ThreadConfig());
 
     /**
      * @brief  Signals to the Coordinator that the cursor update loop should
@@ -48,18 +70,44 @@ public:
      */
     void stopUpdateLoop();
 
+    /**
+     * @brief  Gets statistics on how late the update loop wakes up compared
+     *         to its scheduled update times.
+     *
+     * @return  The update loop's jitter statistics.
+     */
+    const RealTime::JitterStats& getUpdateJitter() const;
+
+    /**
+     * @brief  Adds the Coordinator's performance counters to a stats file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
 private:
     /**
-     * @brief  Continually updates the cursor position at a specific frequency,
-     *         running within another thread.
+     * @brief  Continually updates the cursor position and shape, running
+     *         within another thread.
+     *
+     *  The update frequency is chosen from the current cursor speed, so that
+     * updates are sent roughly once per pixel of cursor movement, up to
+     * maxUpdatesPerSecond. While the cursor is not moving, the loop sleeps
+     * until the next key event. Positions matching the last position sent are
+     * never sent again. Whenever the position or button state changes, it is
+     * also passed to the publisher, if one is set.
      *
-     * @param updatesPerSecond  Number of times per second that the Coordinator
-     *                          should send cursor updates.
+     * @param maxUpdatesPerSecond  Maximum number of times per second that the
+     *                             Coordinator should send cursor updates.
      *
-     * @param coordinator       The coordinator used to start the loop.
+     * @param threadConfig         Scheduling options to apply to the update
+     *                             thread.
+     *
+     * @param coordinator          The coordinator used to start the loop.
      */
-    static void cursorUpdateLoop
-    (const int updatesPerSecond, Coordinator* coordinator);
+    static void cursorUpdateLoop(const int maxUpdatesPerSecond,
+            const RealTime::ThreadConfig threadConfig,
+            Coordinator* coordinator);
 
     /**
      * @brief  Receives keyboard input events, passing them on to the cursor
@@ -72,14 +120,72 @@ private:
     virtual void handleKeyEvent(const KeyListener::Key key,
             const KeyDaemon::EventType actionType) override;
 
+    /**
+     * @brief  Receives a group of simultaneous keyboard input events, passing
+     *         them all on to the cursor tracker before waking the update loop
+     *         once.
+     *
+     * @param events  An array of key input events.
+     *
+     * @param count   The number of events in the array.
+     */
+    virtual void handleKeyEvents(const KeyListener::KeyEvent* events,
+            const size_t count) override;
+
+    /**
+     * @brief  Passes a keyboard input event on to the cursor tracker without
+     *         waking the update loop.
+     *
+     * @param key         The type of key associated with the event.
+     *
+     * @param actionType  Whether the key was pressed, released, or held.
+     */
+    void updateTracker(const KeyListener::Key key,
+            const KeyDaemon::EventType actionType);
+
+    /**
+     * @brief  Sets or clears a button's bit in the button state.
+     *
+     * @param button  A SharedCursor button value.
+     *
+     * @param isDown  Whether the button's key is held down.
+     */
+    void updateButtonState(const uint32_t button, const bool isDown);
+
+    /**
+     * @brief  Wakes the update loop after key input changes.
+     */
+    void signalInputChanged();
+
     // Requests cursor drawing actions:
     CursorPainter& painter;
     // Tracks the position of the cursor:
     CursorTracker& tracker;
+    // Publishes cursor updates to other processes, if not null:
+    CursorPublisher* publisher = nullptr;
     // Runs the update loop:
     std::thread updateThread;
     // Whether the update loop should continue:
     std::atomic<bool> loopShouldContinue;
+    // Wakes the update loop when key input changes or the loop should stop:
+    std::mutex updateLock;
+    std::condition_variable updateCondition;
+    // Whether key input changed since the last loop iteration:
+    bool inputChanged = false;
+    // The cursor shape that should be shown, chosen from key input:
+    std::atomic<CursorAtlas::Shape> requestedShape;
+    // Bitmask of held click keys, using SharedCursor button values:
+    std::atomic<uint32_t> buttonState;
+    // Measures update loop scheduling delays:
+    RealTime::JitterStats updateJitter;
+    // Counts cursor updates sent to the painter:
+    Stats::Counter framesSent;
+    // Counts update loop iterations skipped because the cursor didn't move:
+    Stats::Counter framesSkipped;
+    // Counts key events received:
+    Stats::Counter keyEvents;
+    // Counts cursor shape changes sent to the painter:
+    Stats::Counter shapesSent;
 };
 
 
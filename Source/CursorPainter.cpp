@@ -1,25 +1,97 @@
 #include "CursorPainter.h"
+#include "PainterCommand.h"
+#include "AllocGuard.h"
 #include "Debug.h"
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
 
 #ifdef DEBUG
 static const constexpr char* messagePrefix = "CursorPainter::";
 #endif
 
+// Reads the number of a local X display from a display name like ":0" or
+// ":0.0", returning false if the name doesn't select a local display.
+static bool parseDisplayNumber(const char* displayName, size_t& displayNumber)
+{
+    if (displayName == nullptr || displayName[0] != ':'
+            || displayName[1] < '0' || displayName[1] > '9')
+    {
+        return false;
+    }
+    char* numberEnd = nullptr;
+    const unsigned long number = strtoul(displayName + 1, &numberEnd, 10);
+    if ((*numberEnd != '\0' && *numberEnd != '.')
+            || number > PainterCommand::maxDisplayNumber)
+    {
+        return false;
+    }
+    displayNumber = number;
+    return true;
+}
 
-// Launches the cursor painter daemon and prepares to send it commands.
-CursorPainter::CursorPainter() :
+
+// Launches the cursor painter daemon or painter thread and prepares to send it
+// commands.
+CursorPainter::CursorPainter(const Mode mode,
+        const CursorBackend::Type backendType,
+        const RealTime::ThreadConfig threadConfig) :
 DaemonFramework::DaemonControl(PAINTERD_PATH, PAINTERD_INPUT_PIPE_PATH,
-        PAINTERD_OUTPUT_PIPE_PATH, sizeof(size_t) * 2)
+        PAINTERD_OUTPUT_PIPE_PATH, PainterCommand::messageSize)
 {
+    if (mode == Mode::thread)
+    {
+        DBG_V(messagePrefix << __func__ << ": Starting painter thread.");
+        painterThread.reset(new PainterThread(backendType, threadConfig));
+        return;
+    }
+    if (backendType == CursorBackend::Type::drm)
+    {
+        daemonArgs.push_back("--drm");
+    }
+    else if (backendType == CursorBackend::Type::x11)
+    {
+        // The daemon doesn't inherit CPICursor's environment, so the display
+        // it should connect to is sent once it starts:
+        const char* displayName = getenv("DISPLAY");
+        if (parseDisplayNumber(displayName, x11Display))
+        {
+            daemonArgs.push_back("--x11");
+            sendsDisplay = true;
+        }
+        else
+        {
+            fprintf(stderr, "CursorPainter: \"%s\" isn't a local X display, "
+                    "drawing to the frame buffer instead.\n",
+                    (displayName == nullptr) ? "" : displayName);
+        }
+    }
     DBG_V(messagePrefix << __func__ << ": Starting cursorPainterd:");
-    startDaemon({}, &listener);
+    startDaemon(daemonArgs, &listener);
+    sendDisplay();
     DBG_V(messagePrefix << __func__ << ": cursorPainterd started.");
 }
 
 
-// Ensures the cursor painter daemon is stopped on destruction.
+// Starts a painter thread that draws using an existing cursor backend.
+CursorPainter::CursorPainter(std::unique_ptr<CursorBackend> backend,
+        const RealTime::ThreadConfig threadConfig) :
+DaemonFramework::DaemonControl(PAINTERD_PATH, PAINTERD_INPUT_PIPE_PATH,
+        PAINTERD_OUTPUT_PIPE_PATH, PainterCommand::messageSize)
+{
+    DBG_V(messagePrefix << __func__ << ": Starting painter thread.");
+    painterThread.reset(new PainterThread(std::move(backend), threadConfig));
+}
+
+
+// Ensures the cursor painter daemon or painter thread is stopped on
+// destruction.
 CursorPainter::~CursorPainter()
 {
+    if (painterThread != nullptr)
+    {
+        return;
+    }
     DBG_V(messagePrefix << __func__ << ": Stopping cursorPainterd:");
     stopDaemon();
     DBG_V(messagePrefix << __func__ << ": cursorPainterd stopped.");
@@ -29,28 +101,90 @@ CursorPainter::~CursorPainter()
 // Commands the cursor painter daemon to draw the cursor at a specific
 // coordinate.
 bool CursorPainter::drawCursor(const size_t x, const size_t y)
+{
+    if (painterThread != nullptr)
+    {
+        painterThread->setCursorPos(x, y);
+        return true;
+    }
+    return sendCommand(x, y);
+}
+
+
+// Commands the cursor painter daemon or painter thread to switch the cursor to
+// a different shape.
+bool CursorPainter::setCursorShape(const CursorAtlas::Shape shape)
+{
+    cursorShape = shape;
+    if (painterThread != nullptr)
+    {
+        painterThread->setShape(shape);
+        return true;
+    }
+    return sendCommand(PainterCommand::setShape, static_cast<size_t>(shape));
+}
+
+
+// Sends a message to the painter daemon, restarting the daemon first if it
+// isn't running.
+bool CursorPainter::sendCommand(const size_t first, const size_t second)
 {
     if (! isDaemonRunning())
     {
+        // Restarting the daemon is not part of the steady state:
+        ALLOC_GUARD_ALLOW
         DBG(messagePrefix << __func__
                 << ": Daemon not running, trying to restart:");
-        startDaemon({});
+        daemonRestarts.add();
+        startDaemon(daemonArgs);
         if (! isDaemonRunning())
         {
             DBG(messagePrefix << __func__ << ": Starting daemon failed!");
+            sendFailures.add();
             return false;
         }
+        // The new daemon needs the X display again, and starts with the
+        // default shape:
+        sendDisplay();
+        if (cursorShape != CursorAtlas::Shape(0))
+        {
+            const size_t shapeMessage [2] = { PainterCommand::setShape,
+                    static_cast<size_t>(cursorShape) };
+            messageParent(reinterpret_cast<const unsigned char*>(shapeMessage),
+                    PainterCommand::messageSize);
+            bytesSent.add(PainterCommand::messageSize);
+        }
     }
-    const size_t coordinates [2] = {x, y};
-    messageParent(reinterpret_cast<const unsigned char*>(coordinates),
-            sizeof(size_t) * 2);
+    const size_t message [2] = { first, second };
+    messageParent(reinterpret_cast<const unsigned char*>(message),
+            PainterCommand::messageSize);
+    bytesSent.add(PainterCommand::messageSize);
     return true;
 }
 
 
+// Sends the X display to the painter daemon if it uses the X11 backend.
+void CursorPainter::sendDisplay()
+{
+    if (! sendsDisplay)
+    {
+        return;
+    }
+    const size_t displayMessage [2] = { PainterCommand::setDisplay,
+            x11Display };
+    messageParent(reinterpret_cast<const unsigned char*>(displayMessage),
+            PainterCommand::messageSize);
+    bytesSent.add(PainterCommand::messageSize);
+}
+
+
 // Gets the main display's width in pixels.
 size_t CursorPainter::getDisplayWidth() const
 {
+    if (painterThread != nullptr)
+    {
+        return painterThread->getDisplayWidth();
+    }
     return listener.getDisplayWidth();
 }
 
@@ -58,5 +192,23 @@ size_t CursorPainter::getDisplayWidth() const
 // Gets the main display's height in pixels.
 size_t CursorPainter::getDisplayHeight() const
 {
+    if (painterThread != nullptr)
+    {
+        return painterThread->getDisplayHeight();
+    }
     return listener.getDisplayHeight();
 }
+
+
+// Adds the CursorPainter's performance counters to a stats file.
+void CursorPainter::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter("painter_restarts", daemonRestarts);
+    statsFile.addCounter("painter_send_failures", sendFailures);
+    statsFile.addCounter("painter_bytes_sent", bytesSent);
+    listener.registerStats(statsFile);
+    if (painterThread != nullptr)
+    {
+        painterThread->registerStats(statsFile);
+    }
+}
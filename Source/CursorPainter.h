@@ -7,25 +7,67 @@
 #pragma once
 #include "DaemonControl.h"
 #include "DisplayListener.h"
+#include "PainterThread.h"
+#include "Stats.h"
 #include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
 
 class CursorPainter : private DaemonFramework::DaemonControl
 {
 public:
     /**
-     * @brief  Launches the cursor painter daemon and prepares to send it
-     *         commands.
+     * @brief  Lists the ways the CursorPainter may draw the cursor.
      */
-    CursorPainter();
+    enum class Mode
+    {
+        // Send drawing commands to the cursor painter daemon:
+        daemon,
+        // Draw directly to the frame buffer from a thread within CPICursor:
+        thread
+    };
 
     /**
-     * @brief  Ensures the cursor painter daemon is stopped on destruction.
+     * @brief  Launches the cursor painter daemon or painter thread and
+     *         prepares to send it commands.
+     *
+     * @param mode          Whether to draw using the painter daemon or a
+     *                      painter thread.
+     *
+     * @param backendType   The type of cursor backend the daemon or thread
+     *                      should use.
+     *
+     * @param threadConfig  Scheduling options to apply to the painter thread,
+     *                      if one is used.
+     */
+    CursorPainter(const Mode mode = Mode::daemon,
+            const CursorBackend::Type backendType
+            = CursorBackend::Type::frameBuffer,
+            const RealTime::ThreadConfig threadConfig
+            = RealTime::ThreadConfig());
+
+    /**
+     * @brief  Starts a painter thread that draws using an existing cursor
+     *         backend.
+     *
+     * @param backend       The backend the painter thread will draw with.
+     *
+     * @param threadConfig  Scheduling options to apply to the painter thread.
+     */
+    CursorPainter(std::unique_ptr<CursorBackend> backend,
+            const RealTime::ThreadConfig threadConfig
+            = RealTime::ThreadConfig());
+
+    /**
+     * @brief  Ensures the cursor painter daemon or painter thread is stopped
+     *         on destruction.
      */
     ~CursorPainter();
     
     /**
-     * @brief  Commands the cursor painter daemon to draw the cursor at a 
-     *         specific coordinate.
+     * @brief  Commands the cursor painter daemon or painter thread to draw
+     *         the cursor at a specific coordinate.
      *
      * @param x  Screen x-coordinate, measured in pixels.
      *
@@ -35,6 +77,17 @@ public:
      */
     bool drawCursor(const size_t x, const size_t y);
 
+    /**
+     * @brief  Commands the cursor painter daemon or painter thread to switch
+     *         the cursor to a different shape.
+     *
+     * @param shape  The new cursor shape.
+     *
+     * @return       Whether the CursorPainter was able to send the shape
+     *               command.
+     */
+    bool setCursorShape(const CursorAtlas::Shape shape);
+
     /**
      * @brief  Gets the main display's width in pixels.
      *
@@ -51,7 +104,50 @@ public:
      */
     size_t getDisplayHeight() const;
 
+    /**
+     * @brief  Adds the CursorPainter's performance counters to a stats file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
 private:
+    /**
+     * @brief  Sends a message to the painter daemon, restarting the daemon
+     *         first if it isn't running.
+     *
+     * @param first   The first message value, either a cursor x-coordinate
+     *                or PainterCommand::setShape.
+     *
+     * @param second  The second message value, either a cursor y-coordinate
+     *                or a shape index.
+     *
+     * @return        Whether the message was sent.
+     */
+    bool sendCommand(const size_t first, const size_t second);
+
+    /**
+     * @brief  Sends the X display to the painter daemon if it uses the X11
+     *         backend, which doesn't start until the display is received.
+     */
+    void sendDisplay();
+
     // Receives display resolution sent by the painter daemon.
     DisplayListener listener;
+    // Command line arguments used whenever the painter daemon is started:
+    std::vector<std::string> daemonArgs;
+    // Draws the cursor when the painter daemon isn't used:
+    std::unique_ptr<PainterThread> painterThread;
+    // Whether the painter daemon uses the X11 backend, and needs the number
+    // of the local X display to use whenever it starts:
+    bool sendsDisplay = false;
+    size_t x11Display = 0;
+    // The last cursor shape requested, restored if the daemon restarts:
+    CursorAtlas::Shape cursorShape = CursorAtlas::Shape(0);
+    // Counts attempts to restart the painter daemon:
+    Stats::Counter daemonRestarts;
+    // Counts draw commands that could not be sent:
+    Stats::Counter sendFailures;
+    // Counts bytes written to the painter daemon's pipe:
+    Stats::Counter bytesSent;
 };
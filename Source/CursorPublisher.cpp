@@ -0,0 +1,96 @@
+#include "CursorPublisher.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Creates the shared cursor state segment on construction, replacing any
+// existing segment with the same name.
+CursorPublisher::CursorPublisher(const char* name) : name(name)
+{
+    // Never write into a segment created by another process:
+    shm_unlink(name);
+    const int fileDescriptor = shm_open(name,
+            O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0)
+    {
+        perror("CursorPublisher: failed to create shared cursor state");
+        return;
+    }
+    // Ensure other users can read the segment regardless of the umask:
+    fchmod(fileDescriptor, 0644);
+    if (ftruncate(fileDescriptor, sizeof(SharedCursor::Segment)) != 0)
+    {
+        perror("CursorPublisher: failed to size shared cursor state");
+        close(fileDescriptor);
+        shm_unlink(name);
+        return;
+    }
+    void* mapping = mmap(nullptr, sizeof(SharedCursor::Segment),
+            PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED)
+    {
+        perror("CursorPublisher: failed to map shared cursor state");
+        shm_unlink(name);
+        return;
+    }
+    // The new segment is zero-filled, so readers see it as inactive until the
+    // magic value is stored last:
+    segment = static_cast<SharedCursor::Segment*>(mapping);
+    segment->version.store(SharedCursor::segmentVersion,
+            std::memory_order_relaxed);
+    segment->publisherID.store(static_cast<uint32_t>(getpid()),
+            std::memory_order_relaxed);
+    segment->active.store(1, std::memory_order_relaxed);
+    segment->magic.store(SharedCursor::segmentMagic,
+            std::memory_order_release);
+}
+
+
+// Marks the segment as inactive and removes it on destruction.
+CursorPublisher::~CursorPublisher()
+{
+    if (segment != nullptr)
+    {
+        segment->active.store(0, std::memory_order_release);
+        munmap(segment, sizeof(SharedCursor::Segment));
+        shm_unlink(name);
+    }
+}
+
+
+// Checks if the shared memory segment was created.
+bool CursorPublisher::isReady() const
+{
+    return segment != nullptr;
+}
+
+
+// Publishes a new cursor state.
+void CursorPublisher::publish
+(const uint32_t x, const uint32_t y, const uint32_t buttons)
+{
+    if (segment == nullptr)
+    {
+        return;
+    }
+    const uint32_t sequence
+            = segment->sequence.load(std::memory_order_relaxed);
+    // Mark the update as in progress before any values change:
+    segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->x.store(x, std::memory_order_relaxed);
+    segment->y.store(y, std::memory_order_relaxed);
+    segment->buttons.store(buttons, std::memory_order_relaxed);
+    segment->sequence.store(sequence + 2, std::memory_order_release);
+    updatesPublished.add();
+}
+
+
+// Adds the CursorPublisher's performance counters to a stats file.
+void CursorPublisher::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter("shared_updates_published", updatesPublished);
+}
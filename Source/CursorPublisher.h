@@ -0,0 +1,63 @@
+/**
+ * @file  CursorPublisher.h
+ *
+ * @brief  Publishes the cursor state to other local processes through the
+ *         shared memory segment described in SharedCursor.h.
+ */
+
+#pragma once
+#include "SharedCursor.h"
+#include "Stats.h"
+#include <cstdint>
+
+class CursorPublisher
+{
+public:
+    /**
+     * @brief  Creates the shared cursor state segment on construction. Any
+     *         existing segment with the same name is replaced.
+     *
+     * @param name  The shared memory object name.
+     */
+    CursorPublisher(const char* name = SharedCursor::segmentName);
+
+    /**
+     * @brief  Marks the segment as inactive and removes it on destruction.
+     */
+    virtual ~CursorPublisher();
+
+    /**
+     * @brief  Checks if the shared memory segment was created.
+     *
+     * @return  Whether cursor updates will be published.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief  Publishes a new cursor state. This must only be called from one
+     *         thread at a time.
+     *
+     * @param x        Cursor x-coordinate, measured in pixels.
+     *
+     * @param y        Cursor y-coordinate, measured in pixels.
+     *
+     * @param buttons  A bitmask of held SharedCursor button values.
+     */
+    void publish(const uint32_t x, const uint32_t y, const uint32_t buttons);
+
+    /**
+     * @brief  Adds the CursorPublisher's performance counters to a stats
+     *         file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
+private:
+    // The shared memory object name:
+    const char* name;
+    // The mapped shared memory segment, or nullptr if creating it failed:
+    SharedCursor::Segment* segment = nullptr;
+    // Counts published cursor updates:
+    Stats::Counter updatesPublished;
+};
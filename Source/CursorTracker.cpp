@@ -1,5 +1,6 @@
 #include "CursorTracker.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 
 // Cursor speed and acceleration, measured in pixels per millisecond and pixels
@@ -167,3 +168,28 @@ CursorTracker::Point CursorTracker::getCursorPos()
     };
     return pos;
 }
+
+
+// Gets the current speed of the cursor along its fastest moving axis.
+double CursorTracker::getCursorSpeed()
+{
+    std::lock_guard<std::mutex> lock(cursorLock);
+    TimePoint currentTime = getCurrentTime();
+
+    // Find the speed contributed by a single direction key:
+    const auto getKeySpeed = [&currentTime, this] (const DirectionKey key)
+    {
+        const int keyIdx = static_cast<int>(key);
+        if (! heldKeys[keyIdx])
+        {
+            return 0.0;
+        }
+        const Duration heldTime = currentTime - lastUpdateTimes[keyIdx];
+        return std::min(maxSpeed, minSpeed + accel * heldTime.count());
+    };
+    const double xSpeed = std::abs(getKeySpeed(DirectionKey::right)
+            - getKeySpeed(DirectionKey::left));
+    const double ySpeed = std::abs(getKeySpeed(DirectionKey::down)
+            - getKeySpeed(DirectionKey::up));
+    return std::max(xSpeed, ySpeed);
+}
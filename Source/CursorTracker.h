@@ -71,6 +71,15 @@ public:
      */
     Point getCursorPos();
 
+    /**
+     * @brief  Gets the current speed of the cursor along its fastest moving
+     *         axis.
+     *
+     * @return  The cursor speed in pixels per millisecond, or zero if the
+     *          cursor is not moving.
+     */
+    double getCursorSpeed();
+
 private:
     // Time measurement types used by CursorTracker:
     typedef std::chrono::high_resolution_clock UpdateClock;
@@ -20,12 +20,22 @@ size_t DisplayListener::getDisplayHeight() const
 }
 
 
+// Adds the DisplayListener's performance counters to a stats file.
+void DisplayListener::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter("display_invalid_messages", invalidMessages);
+    statsFile.addCounter("display_bytes_received", bytesReceived);
+}
+
+
 // Read the display resolution sent by the cursor painter daemon.
 void DisplayListener::processData
 (const unsigned char* data, const size_t size)
 {
+    bytesReceived.add(size);
     if (size != (sizeof(size_t) * 2))
     {
+        invalidMessages.add();
         DBG(messagePrefix << __func__
                 << ": Ignoring message with invalid size " << size);
         return;
@@ -7,6 +7,7 @@
 
 #pragma once
 #include "Pipe_Listener.h"
+#include "Stats.h"
 
 class DisplayListener : public DaemonFramework::Pipe::Listener
 {
@@ -31,6 +32,13 @@ public:
      */
     size_t getDisplayHeight() const;
 
+    /**
+     * @brief  Adds the DisplayListener's performance counters to a stats file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
 private:
     /**
      * @brief  Read the display resolution sent by the cursor painter daemon.
@@ -46,4 +54,8 @@ private:
 
     size_t width = 0;
     size_t height = 0;
+    // Counts messages ignored because they were invalid:
+    Stats::Counter invalidMessages;
+    // Counts bytes read from the painter daemon's pipe:
+    Stats::Counter bytesReceived;
 };
@@ -0,0 +1,414 @@
+#include "EvdevListener.h"
+#include "AllocGuard.h"
+#include "Debug.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#ifdef DEBUG
+// Print the full class name before all debug output:
+static const constexpr char* messagePrefix = "EvdevListener::";
+#endif
+
+// Directory holding input event device files:
+static const constexpr char* inputDir = "/dev/input";
+// Prefix shared by all input event device file names:
+static const constexpr char* eventFilePrefix = "event";
+// Maximum number of input events read at once:
+static const constexpr size_t readBufferSize = 64;
+// Input event value sent for each key autorepeat:
+static const constexpr int keyRepeatValue = 2;
+// Identifies the stop event in epoll results:
+static const constexpr uint32_t stopEventID = UINT32_MAX;
+
+
+// Stores the InputHandler on construction.
+EvdevListener::EvdevListener(KeyListener::InputHandler& inputHandler) :
+    inputHandler(inputHandler), shouldStop(false) { }
+
+
+// Stops reading input and closes all input devices on destruction.
+EvdevListener::~EvdevListener()
+{
+    stopReading();
+}
+
+
+// Assigns an input Key type to a specific linux keyboard code.
+void EvdevListener::setKeyCode
+(const int inputCode, const KeyListener::Key keyType)
+{
+    keyCodes.set(inputCode, keyType);
+}
+
+
+// Sets scheduling options to apply to the input reading thread.
+void EvdevListener::setListenerThreadConfig
+(const RealTime::ThreadConfig threadConfig)
+{
+    listenerThreadConfig = threadConfig;
+}
+
+
+// Opens all input devices that provide tracked keys, and starts reading them
+// in a new thread.
+bool EvdevListener::startReading()
+{
+    if (readThread.joinable())
+    {
+        DBG(messagePrefix << __func__ << ": Already reading input!");
+        return true;
+    }
+    if (! openDevices())
+    {
+        closeDevices();
+        return false;
+    }
+    shouldStop.store(false);
+    readThread = std::thread([this]() { readLoop(); });
+    return true;
+}
+
+
+// Stops reading input, waiting for the input thread to exit.
+void EvdevListener::stopReading()
+{
+    if (readThread.joinable())
+    {
+        shouldStop.store(true);
+        const uint64_t wakeValue = 1;
+        if (write(stopEventFD, &wakeValue, sizeof(wakeValue)) < 0)
+        {
+            DBG_PERROR("EvdevListener: failed to signal input thread");
+        }
+        readThread.join();
+    }
+    closeDevices();
+}
+
+
+// Adds the EvdevListener's performance counters to a stats file.
+void EvdevListener::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter("evdev_events_read", eventsRead);
+    statsFile.addCounter("evdev_frames_delivered", framesDelivered);
+    statsFile.addCounter("evdev_frames_dropped", framesDropped);
+    statsFile.addCounter("evdev_repeats_dropped", repeatsDropped);
+    statsFile.addCounter("evdev_keys_resynced", keysResynced);
+    statsFile.addCounter("evdev_devices_removed", devicesRemoved);
+}
+
+
+// Opens all input devices that provide tracked keys.
+bool EvdevListener::openDevices()
+{
+    epollFD = epoll_create1(EPOLL_CLOEXEC);
+    stopEventFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFD < 0 || stopEventFD < 0)
+    {
+        perror("EvdevListener: failed to create epoll descriptors");
+        return false;
+    }
+    struct epoll_event stopEvent;
+    memset(&stopEvent, 0, sizeof(stopEvent));
+    stopEvent.events = EPOLLIN;
+    stopEvent.data.u32 = stopEventID;
+    epoll_ctl(epollFD, EPOLL_CTL_ADD, stopEventFD, &stopEvent);
+
+    DIR* directory = opendir(inputDir);
+    if (directory == nullptr)
+    {
+        perror("EvdevListener: failed to open input directory");
+        return false;
+    }
+    bool permissionDenied = false;
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != nullptr)
+    {
+        if (strncmp(entry->d_name, eventFilePrefix, strlen(eventFilePrefix))
+                != 0)
+        {
+            continue;
+        }
+        char path [PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", inputDir, entry->d_name);
+        const int fileDescriptor = open(path,
+                O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fileDescriptor < 0)
+        {
+            permissionDenied = permissionDenied || (errno == EACCES);
+            continue;
+        }
+        // Only keep devices that provide at least one tracked key:
+        unsigned char keyBits [keyBitBytes];
+        memset(keyBits, 0, sizeof(keyBits));
+        bool hasTrackedKey = false;
+        if (ioctl(fileDescriptor, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits)
+                >= 0)
+        {
+            for (size_t i = 0; i < keyCodes.getTrackedCount(); i++)
+            {
+                const int code = keyCodes.getTrackedCode(i);
+                if (keyBits[code / 8] & (1 << (code % 8)))
+                {
+                    hasTrackedKey = true;
+                    break;
+                }
+            }
+        }
+        if (! hasTrackedKey)
+        {
+            close(fileDescriptor);
+            continue;
+        }
+        DBG(messagePrefix << __func__ << ": Reading keys from " << path);
+        Device device;
+        device.fileDescriptor = fileDescriptor;
+        device.frameEventCount = 0;
+        device.droppingFrame = false;
+        // No keys have been reported as pressed yet:
+        memset(device.keyState, 0, sizeof(device.keyState));
+        devices.push_back(device);
+    }
+    closedir(directory);
+
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        struct epoll_event inputEvent;
+        memset(&inputEvent, 0, sizeof(inputEvent));
+        inputEvent.events = EPOLLIN;
+        inputEvent.data.u32 = i;
+        epoll_ctl(epollFD, EPOLL_CTL_ADD, devices[i].fileDescriptor,
+                &inputEvent);
+    }
+    if (devices.empty())
+    {
+        fprintf(stderr, "EvdevListener: No usable key input devices found%s\n",
+                permissionDenied ? " (permission denied)." : ".");
+        return false;
+    }
+    return true;
+}
+
+
+// Closes all open input devices and epoll file descriptors.
+void EvdevListener::closeDevices()
+{
+    for (Device& device : devices)
+    {
+        if (device.fileDescriptor >= 0)
+        {
+            close(device.fileDescriptor);
+        }
+    }
+    devices.clear();
+    if (epollFD >= 0)
+    {
+        close(epollFD);
+        epollFD = -1;
+    }
+    if (stopEventFD >= 0)
+    {
+        close(stopEventFD);
+        stopEventFD = -1;
+    }
+}
+
+
+// Waits for and processes input events until the listener is stopped, running
+// within the input thread.
+void EvdevListener::readLoop()
+{
+    RealTime::configureThread(listenerThreadConfig, "evdev input thread");
+    struct epoll_event readyEvents [8];
+    struct input_event inputEvents [readBufferSize];
+    while (! shouldStop.load())
+    {
+        ALLOC_GUARD_SCOPE
+        const int readyCount = epoll_wait(epollFD, readyEvents, 8, -1);
+        if (readyCount < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("EvdevListener: epoll_wait failed");
+            return;
+        }
+        for (int i = 0; i < readyCount; i++)
+        {
+            if (readyEvents[i].data.u32 == stopEventID)
+            {
+                continue;
+            }
+            Device& device = devices[readyEvents[i].data.u32];
+            if (device.fileDescriptor < 0)
+            {
+                continue;
+            }
+            if ((readyEvents[i].events & (EPOLLHUP | EPOLLERR)) != 0)
+            {
+                removeDevice(device);
+                continue;
+            }
+            const ssize_t bytesRead = read(device.fileDescriptor, inputEvents,
+                    sizeof(inputEvents));
+            if (bytesRead < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                // Read errors such as ENODEV mean the device is gone:
+                removeDevice(device);
+                continue;
+            }
+            if (bytesRead <= 0)
+            {
+                continue;
+            }
+            const size_t eventCount = bytesRead / sizeof(struct input_event);
+            for (size_t e = 0; e < eventCount; e++)
+            {
+                const struct input_event& event = inputEvents[e];
+                if (event.type == EV_SYN && event.code == SYN_DROPPED)
+                {
+                    // Events were lost, so the current frame is incomplete:
+                    device.droppingFrame = true;
+                    device.frameEventCount = 0;
+                    framesDropped.add();
+                }
+                else if (event.type == EV_SYN && event.code == SYN_REPORT)
+                {
+                    if (device.droppingFrame)
+                    {
+                        // The dropped events may have pressed or released
+                        // keys, so read the key state directly:
+                        unsigned char keyBits [keyBitBytes];
+                        memset(keyBits, 0, sizeof(keyBits));
+                        if (ioctl(device.fileDescriptor,
+                                EVIOCGKEY(sizeof(keyBits)), keyBits) >= 0)
+                        {
+                            syncKeyState(device, keyBits);
+                        }
+                    }
+                    else
+                    {
+                        deliverFrame(device);
+                    }
+                    device.droppingFrame = false;
+                    device.frameEventCount = 0;
+                }
+                else if (EDGE_ONLY_KEYS && event.type == EV_KEY
+                        && event.value == keyRepeatValue)
+                {
+                    // Repeats don't change any key state:
+                    repeatsDropped.add();
+                }
+                else if (event.type == EV_KEY && ! device.droppingFrame
+                        && device.frameEventCount < maxFrameEvents)
+                {
+                    KeyListener::KeyEvent& keyEvent
+                            = device.frameEvents[device.frameEventCount];
+                    if (! keyCodes.find(event.code, keyEvent.key))
+                    {
+                        continue;
+                    }
+                    switch (event.value)
+                    {
+                        case 0:
+                            keyEvent.actionType
+                                    = KeyDaemon::EventType::released;
+                            break;
+                        case 1:
+                            keyEvent.actionType
+                                    = KeyDaemon::EventType::pressed;
+                            break;
+                        default:
+                            keyEvent.actionType = KeyDaemon::EventType::held;
+                    }
+                    device.frameCodes[device.frameEventCount] = event.code;
+                    device.frameEventCount++;
+                    eventsRead.add();
+                }
+            }
+        }
+    }
+}
+
+
+// Passes a device's current input frame to the InputHandler, and records the
+// key states it sets.
+void EvdevListener::deliverFrame(Device& device)
+{
+    if (device.frameEventCount == 0)
+    {
+        return;
+    }
+    for (size_t i = 0; i < device.frameEventCount; i++)
+    {
+        const int code = device.frameCodes[i];
+        const unsigned char mask = 1 << (code % 8);
+        switch (device.frameEvents[i].actionType)
+        {
+            case KeyDaemon::EventType::pressed:
+                device.keyState[code / 8] |= mask;
+                break;
+            case KeyDaemon::EventType::released:
+                device.keyState[code / 8] &= ~mask;
+                break;
+            default:
+                break;
+        }
+    }
+    inputHandler.handleKeyEvents(device.frameEvents, device.frameEventCount);
+    framesDelivered.add();
+    device.frameEventCount = 0;
+}
+
+
+// Sends press or release events for each tracked key whose state differs from
+// the state last passed to the InputHandler.
+void EvdevListener::syncKeyState(Device& device, const unsigned char* keyBits)
+{
+    device.frameEventCount = 0;
+    for (size_t i = 0; i < keyCodes.getTrackedCount()
+            && device.frameEventCount < maxFrameEvents; i++)
+    {
+        const int code = keyCodes.getTrackedCode(i);
+        const unsigned char mask = 1 << (code % 8);
+        const bool isDown = (keyBits[code / 8] & mask) != 0;
+        if (isDown == ((device.keyState[code / 8] & mask) != 0))
+        {
+            continue;
+        }
+        KeyListener::KeyEvent& keyEvent
+                = device.frameEvents[device.frameEventCount];
+        keyCodes.find(code, keyEvent.key);
+        keyEvent.actionType = isDown ? KeyDaemon::EventType::pressed
+                : KeyDaemon::EventType::released;
+        device.frameCodes[device.frameEventCount] = code;
+        device.frameEventCount++;
+        keysResynced.add();
+    }
+    deliverFrame(device);
+}
+
+
+// Stops reading a device that was removed or failed, releasing any tracked
+// keys it held.
+void EvdevListener::removeDevice(Device& device)
+{
+    DBG(messagePrefix << __func__ << ": Input device removed.");
+    epoll_ctl(epollFD, EPOLL_CTL_DEL, device.fileDescriptor, nullptr);
+    close(device.fileDescriptor);
+    device.fileDescriptor = -1;
+    device.droppingFrame = false;
+    const unsigned char releasedKeys [keyBitBytes] = {0};
+    syncKeyState(device, releasedKeys);
+    devicesRemoved.add();
+}
@@ -0,0 +1,182 @@
+/**
+ * @file  EvdevListener.h
+ *
+ * @brief  Reads keyboard input directly from Linux input event devices, as an
+ *         alternative to launching the key listener daemon.
+ *
+ *  EvdevListener opens every /dev/input/event* device that reports any of its
+ * tracked key codes, and reads them all from a single thread using epoll. Key
+ * events from each input frame are collected until the frame's SYN_REPORT
+ * event, then passed to the InputHandler as a single group. If the kernel
+ * drops events, the device's key state is read again once the next frame
+ * ends, and press or release events are sent for each tracked key that
+ * changed. Devices that are removed or fail are closed, releasing any keys
+ * they held. When built with
+ * EDGE_ONLY_KEYS=1, key autorepeat events are counted and dropped before any
+ * other processing, so frames holding only repeats never reach the
+ * InputHandler. Reading event devices requires root privileges or membership
+ * in the input group.
+ */
+
+#pragma once
+#include "KeyListener.h"
+#include "RealTime.h"
+#include "Stats.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class EvdevListener
+{
+public:
+    /**
+     * @brief  Stores the InputHandler on construction.
+     *
+     * @param inputHandler  The object that will receive key input events.
+     */
+    EvdevListener(KeyListener::InputHandler& inputHandler);
+
+    /**
+     * @brief  Stops reading input and closes all input devices on
+     *         destruction.
+     */
+    virtual ~EvdevListener();
+
+    /**
+     * @brief  Assigns an input Key type to a specific linux keyboard code.
+     *         All required keys must be assigned before starting to read
+     *         input.
+     *
+     * @param inputCode  A Linux keyboard input code (as defined in
+     *                   <linux/input-event-codes.h>) that will be tracked.
+     *
+     * @param keyType    The key input type that will be associated with that
+     *                   key code.
+     */
+    void setKeyCode(const int inputCode, const KeyListener::Key keyType);
+
+    /**
+     * @brief  Sets scheduling options to apply to the input reading thread.
+     *         This must be called before starting to read input.
+     *
+     * @param threadConfig  Scheduling options for the input thread.
+     */
+    void setListenerThreadConfig(const RealTime::ThreadConfig threadConfig);
+
+    /**
+     * @brief  Opens all input devices that provide tracked keys, and starts
+     *         reading them in a new thread.
+     *
+     * @return  Whether at least one input device was opened and the input
+     *          thread started.
+     */
+    bool startReading();
+
+    /**
+     * @brief  Stops reading input, waiting for the input thread to exit.
+     */
+    void stopReading();
+
+    /**
+     * @brief  Adds the EvdevListener's performance counters to a stats file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
+private:
+    /**
+     * @brief  Opens all input devices that provide tracked keys.
+     *
+     * @return  Whether at least one device was opened.
+     */
+    bool openDevices();
+
+    /**
+     * @brief  Closes all open input devices and epoll file descriptors.
+     */
+    void closeDevices();
+
+    /**
+     * @brief  Waits for and processes input events until the listener is
+     *         stopped, running within the input thread.
+     */
+    void readLoop();
+
+    // Maximum number of key events collected within a single input frame:
+    static const constexpr size_t maxFrameEvents = 16;
+    // Number of bytes needed to hold one bit for each possible key code:
+    static const constexpr size_t keyBitBytes = (KEY_MAX / 8) + 1;
+
+    /**
+     * @brief  An open input device, along with the key events read from its
+     *         current input frame.
+     */
+    struct Device
+    {
+        // Open device file, or -1 once the device is removed:
+        int fileDescriptor;
+        KeyListener::KeyEvent frameEvents [maxFrameEvents];
+        // Key codes of each event in frameEvents:
+        int frameCodes [maxFrameEvents];
+        size_t frameEventCount;
+        // Set after the kernel drops events, until the next SYN_REPORT:
+        bool droppingFrame;
+        // Key state bits last passed to the InputHandler, indexed by code:
+        unsigned char keyState [keyBitBytes];
+    };
+
+    /**
+     * @brief  Passes a device's current input frame to the InputHandler, and
+     *         records the key states it sets.
+     *
+     * @param device  The device whose frame is complete.
+     */
+    void deliverFrame(Device& device);
+
+    /**
+     * @brief  Sends press or release events for each tracked key whose state
+     *         differs from the state last passed to the InputHandler.
+     *
+     * @param device   The device being synchronized.
+     *
+     * @param keyBits  The device's actual key state bits, indexed by code.
+     */
+    void syncKeyState(Device& device, const unsigned char* keyBits);
+
+    /**
+     * @brief  Stops reading a device that was removed or failed, releasing
+     *         any tracked keys it held.
+     *
+     * @param device  The device to remove.
+     */
+    void removeDevice(Device& device);
+
+    // Object responsible for deciding what to do with input events:
+    KeyListener::InputHandler& inputHandler;
+    // Maps key code numbers to the Key type they control:
+    KeyListener::KeyCodeMap keyCodes;
+    // All open input devices:
+    std::vector<Device> devices;
+    // Waits for input on all devices:
+    int epollFD = -1;
+    // Wakes the input thread when it should stop:
+    int stopEventFD = -1;
+    // Reads input:
+    std::thread readThread;
+    std::atomic<bool> shouldStop;
+    // Scheduling options for the input thread:
+    RealTime::ThreadConfig listenerThreadConfig;
+    // Counts key events read from all devices:
+    Stats::Counter eventsRead;
+    // Counts input frames passed to the InputHandler:
+    Stats::Counter framesDelivered;
+    // Counts input frames discarded after the kernel dropped events:
+    Stats::Counter framesDropped;
+    // Counts key autorepeat events dropped in edge-only mode:
+    Stats::Counter repeatsDropped;
+    // Counts key events sent to correct key state after dropped events:
+    Stats::Counter keysResynced;
+    // Counts devices closed after being removed or failing:
+    Stats::Counter devicesRemoved;
+};
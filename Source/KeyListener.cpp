@@ -1,5 +1,8 @@
 #include "KeyListener.h"
+#include "AllocGuard.h"
 #include "Debug.h"
+#include <cstring>
+#include <vector>
 
 #ifdef DEBUG
 // Print the full class name before all debug output:
@@ -7,6 +10,47 @@ static const constexpr char* messagePrefix = "KeyListener::";
 #endif
 
 
+// Marks all key codes as untracked on construction.
+KeyListener::KeyCodeMap::KeyCodeMap()
+{
+    memset(keyTypes, untracked, sizeof(keyTypes));
+}
+
+
+// Assigns a Key type to a key code.
+void KeyListener::KeyCodeMap::set(const int code, const Key keyType)
+{
+    if (code < 0 || code >= KEY_CNT)
+    {
+        return;
+    }
+    if (keyTypes[code] == untracked)
+    {
+        if (trackedCount == maxTrackedCodes)
+        {
+            return;
+        }
+        trackedCodes[trackedCount] = code;
+        trackedCount++;
+    }
+    keyTypes[code] = static_cast<uint8_t>(keyType);
+}
+
+
+// Gets the number of key codes that were assigned Key types.
+size_t KeyListener::KeyCodeMap::getTrackedCount() const
+{
+    return trackedCount;
+}
+
+
+// Gets one of the tracked key codes.
+int KeyListener::KeyCodeMap::getTrackedCode(const size_t index) const
+{
+    return trackedCodes[index];
+}
+
+
 // Stores the InputHandler on construction.
 KeyListener::KeyListener(InputHandler& inputHandler) :
     inputHandler(inputHandler) { }
@@ -15,7 +59,7 @@ KeyListener::KeyListener(InputHandler& inputHandler) :
 // Assigns an input Key type to a specific linux keyboard code.
 void KeyListener::setKeyCode(const int inputCode, const Key keyType)
 {
-    keyCodes[inputCode] = keyType;
+    keyCodes.set(inputCode, keyType);
 }
 
 
@@ -29,24 +73,55 @@ void KeyListener::startKeyDaemon()
         return;
     }
     std::vector<int> trackedCodes;
-    for (const auto& iter : keyCodes)
+    for (size_t i = 0; i < keyCodes.getTrackedCount(); i++)
     {
-        trackedCodes.push_back(iter.first);
+        trackedCodes.push_back(keyCodes.getTrackedCode(i));
     }
     DBG_ASSERT(trackedCodes.size() == KD_KEY_LIMIT);
     KeyDaemon::Controller::startKeyDaemon(trackedCodes);
 }
 
 
-// Passes valid key event data on to the InputHandler.
+// Sets scheduling options to apply to the thread that receives key events from
+// the daemon.
+void KeyListener::setListenerThreadConfig
+(const RealTime::ThreadConfig threadConfig)
+{
+    listenerThreadConfig = threadConfig;
+}
+
+
+// Adds the KeyListener's performance counters to a stats file.
+void KeyListener::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter("keyd_repeats_dropped", repeatsDropped);
+}
+
+
+// Passes valid key event data on to the InputHandler, or drops key autorepeat
+// events in edge-only mode.
 void KeyListener::handleKeyEvent(const KeyDaemon::KeyMessage& keyMessage)
 {
-    try
+    if (! listenerThreadConfigured)
+    {
+        // Key events always arrive on the daemon pipe's listener thread, so
+        // it can only be configured from here:
+        RealTime::configureThread(listenerThreadConfig, "key event thread");
+        listenerThreadConfigured = true;
+    }
+    ALLOC_GUARD_SCOPE
+    if (EDGE_ONLY_KEYS && keyMessage.event == KeyDaemon::EventType::held)
+    {
+        // Repeats don't change any key state:
+        repeatsDropped.add();
+        return;
+    }
+    Key keyType;
+    if (keyCodes.find(keyMessage.keyCode, keyType))
     {
-        const Key keyType = keyCodes.at(keyMessage.keyCode);
         inputHandler.handleKeyEvent(keyType, keyMessage.event);
     }
-    catch (const std::out_of_range& e)
+    else
     {
         DBG(messagePrefix << __func__ << ": Received invalid key code "
                 << keyMessage.keyCode);
@@ -7,7 +7,14 @@
 
 #pragma once
 #include "Controller.h"
-#include <map>
+#include "RealTime.h"
+#include "Stats.h"
+#include <cstddef>
+#include <cstdint>
+#include <linux/input-event-codes.h>
+
+class EvdevListener;
+class TrainingWorkload;
 
 class KeyListener : protected KeyDaemon::Controller
 {
@@ -26,6 +33,84 @@ public:
         exit
     };
 
+    /**
+     * @brief  A single key input event.
+     */
+    struct KeyEvent
+    {
+        Key key;
+        KeyDaemon::EventType actionType;
+    };
+
+    /**
+     * @brief  Maps Linux key codes to the Key types they control, using a
+     *         fixed table so that looking up a key never allocates memory or
+     *         throws exceptions.
+     */
+    class KeyCodeMap
+    {
+    public:
+        // Maximum number of key codes that may be tracked:
+        static const constexpr size_t maxTrackedCodes = 16;
+
+        KeyCodeMap();
+
+        /**
+         * @brief  Assigns a Key type to a key code. Invalid key codes, and
+         *         new key codes beyond maxTrackedCodes, are ignored.
+         *
+         * @param code     A Linux keyboard input code.
+         *
+         * @param keyType  The key input type that the code will control.
+         */
+        void set(const int code, const Key keyType);
+
+        /**
+         * @brief  Finds the Key type assigned to a key code.
+         *
+         * @param code     A Linux keyboard input code.
+         *
+         * @param keyType  Used to return the code's Key type.
+         *
+         * @return         Whether the code was assigned a Key type.
+         */
+        inline bool find(const int code, Key& keyType) const
+        {
+            if (code < 0 || code >= KEY_CNT || keyTypes[code] == untracked)
+            {
+                return false;
+            }
+            keyType = static_cast<Key>(keyTypes[code]);
+            return true;
+        }
+
+        /**
+         * @brief  Gets the number of key codes that were assigned Key types.
+         *
+         * @return  The number of tracked key codes.
+         */
+        size_t getTrackedCount() const;
+
+        /**
+         * @brief  Gets one of the tracked key codes.
+         *
+         * @param index  The index of a tracked code, less than
+         *               getTrackedCount().
+         *
+         * @return       The key code at that index.
+         */
+        int getTrackedCode(const size_t index) const;
+
+    private:
+        // Marks key codes that have no Key type:
+        static const constexpr uint8_t untracked = UINT8_MAX;
+        // Key types indexed by key code:
+        uint8_t keyTypes [KEY_CNT];
+        // All tracked key codes, in the order they were assigned:
+        int trackedCodes [maxTrackedCodes];
+        size_t trackedCount = 0;
+    };
+
     /**
      * @brief  An abstract interface for classes that handle CPICursor input
      *         events.
@@ -34,6 +119,8 @@ public:
     {
     public:
         friend KeyListener;
+        friend EvdevListener;
+        friend TrainingWorkload;
 
         InputHandler() { }
 
@@ -50,6 +137,23 @@ public:
          */
         virtual void handleKeyEvent
         (const Key key, const KeyDaemon::EventType actionType) = 0;
+
+        /**
+         * @brief  Handles a group of keyboard input events that occurred at
+         *         the same time. By default, each event is passed to
+         *         handleKeyEvent in order.
+         *
+         * @param events  An array of key input events.
+         *
+         * @param count   The number of events in the array.
+         */
+        virtual void handleKeyEvents(const KeyEvent* events, const size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                handleKeyEvent(events[i].key, events[i].actionType);
+            }
+        }
     };
 
     
@@ -80,6 +184,22 @@ public:
      */
     void startKeyDaemon();
 
+    /**
+     * @brief  Sets scheduling options to apply to the thread that receives
+     *         key events from the daemon. This must be called before starting
+     *         the daemon.
+     *
+     * @param threadConfig  Scheduling options for the key event thread.
+     */
+    void setListenerThreadConfig(const RealTime::ThreadConfig threadConfig);
+
+    /**
+     * @brief  Adds the KeyListener's performance counters to a stats file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
     // Grant limited access to DaemonControl public methods:
     using DaemonFramework::DaemonControl::stopDaemon;
     using DaemonFramework::DaemonControl::isDaemonRunning;
@@ -88,7 +208,9 @@ public:
 
 private:
     /**
-     * @brief  Passes valid key event data on to the InputHandler.
+     * @brief  Passes valid key event data on to the InputHandler. When built
+     *         with EDGE_ONLY_KEYS=1, key autorepeat events are dropped
+     *         instead.
      *
      * @param keyMessage  A key event message sent by the daemon.
      */
@@ -98,5 +220,11 @@ private:
     // Object responsible for deciding what to do with input events:
     InputHandler& inputHandler;
     // Maps key code numbers to the Key type they control:
-    std::map<int, Key> keyCodes;
+    KeyCodeMap keyCodes;
+    // Scheduling options for the key event thread, applied when the first
+    // event arrives on that thread:
+    RealTime::ThreadConfig listenerThreadConfig;
+    bool listenerThreadConfigured = false;
+    // Counts key autorepeat events dropped in edge-only mode:
+    Stats::Counter repeatsDropped;
 };
@@ -6,9 +6,16 @@
 
 #include "CursorPainter.h"
 #include "KeyListener.h"
+#include "EvdevListener.h"
 #include "Coordinator.h"
+#include "CursorPublisher.h"
+#include "TrainingWorkload.h"
+#include "RealTime.h"
+#include "Stats.h"
 #include "Debug.h"
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <unistd.h>
 #include <linux/input-event-codes.h>
@@ -58,18 +65,49 @@ private:
     }
 };
 
-int main(int argc, char** argv)
+// Creates scheduling options for a cursor pipeline thread or process, using the
+// real-time policy and priority defined at build time.
+static RealTime::ThreadConfig getThreadConfig(const int cpu)
 {
-    std::cout << "Starting cursor painter:\n";
-    CursorPainter painter;
-    while(painter.getDisplayWidth() == 0)
+    RealTime::ThreadConfig config;
+    config.policy = RealTime::parsePolicy(RT_POLICY);
+    config.priority = RT_PRIORITY;
+    config.cpu = cpu;
+    return config;
+}
+
+// Checks if a command line option was provided.
+static bool hasOption(const int argc, char** argv, const char* option)
+{
+    for (int i = 1; i < argc; i++)
     {
-        sleep(1);
+        if (strcmp(argv[i], option) == 0)
+        {
+            return true;
+        }
     }
-    CursorTracker tracker(0, 0, painter.getDisplayWidth(),
-            painter.getDisplayHeight());
-    Coordinator coordinator(painter, tracker);
-    KeyListener listener(coordinator);
+    return false;
+}
+
+// Gets the value following a command line option, or null if the option
+// wasn't provided with a value.
+static const char* getOptionValue(const int argc, char** argv,
+        const char* option)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], option) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+// Assigns all CPICursor input keys to a KeyListener or EvdevListener.
+template <class ListenerType>
+static void assignKeyCodes(ListenerType& listener)
+{
     listener.setKeyCode(KEY_UP, KeyListener::Key::up);
     listener.setKeyCode(KEY_DOWN, KeyListener::Key::down);
     listener.setKeyCode(KEY_LEFT, KeyListener::Key::left);
@@ -77,8 +115,107 @@ int main(int argc, char** argv)
     listener.setKeyCode(KEY_SPACE, KeyListener::Key::leftClick);
     listener.setKeyCode(KEY_RIGHTALT, KeyListener::Key::rightClick);
     listener.setKeyCode(KEY_ESC, KeyListener::Key::exit);
-    listener.startKeyDaemon();
-    coordinator.startUpdateLoop(60);
+    listener.setListenerThreadConfig(getThreadConfig(KEY_LISTENER_CPU));
+}
+
+int main(int argc, char** argv)
+{
+    // With --train or --benchmark, replay the fixed training or benchmark
+    // workload without using any input devices, drawing to the frame buffer
+    // that follows the option, then exit:
+    const bool benchmark = hasOption(argc, argv, "--benchmark");
+    if (benchmark || hasOption(argc, argv, "--train"))
+    {
+        const char* option = benchmark ? "--benchmark" : "--train";
+        const char* frameBufferPath = getOptionValue(argc, argv, option);
+        if (frameBufferPath == nullptr)
+        {
+            std::cerr << "Usage: CPICursor " << option
+                    << " <frame buffer path>\n";
+            return 1;
+        }
+        TrainingWorkload workload(benchmark
+                ? TrainingWorkload::Trace::benchmark
+                : TrainingWorkload::Trace::training);
+        return workload.run(frameBufferPath);
+    }
+    // With --alloc-check, replay the training key trace and fail if it
+    // allocates heap memory after warming up:
+    if (hasOption(argc, argv, "--alloc-check"))
+    {
+        TrainingWorkload workload;
+        return workload.checkAllocations();
+    }
+    if (RT_LOCK_MEMORY)
+    {
+        RealTime::lockMemory();
+    }
+    std::cout << "Starting cursor painter:\n";
+    // With --painter-thread, draw the cursor from a thread within CPICursor
+    // instead of launching the painter daemon:
+    const CursorPainter::Mode painterMode
+            = hasOption(argc, argv, "--painter-thread")
+            ? CursorPainter::Mode::thread : CursorPainter::Mode::daemon;
+    // With --drm, show the cursor on a DRM/KMS hardware cursor plane instead
+    // of drawing it into the frame buffer. With --x11, show the cursor in an
+    // overlay window within the X11 session on $DISPLAY:
+    CursorBackend::Type backendType = CursorBackend::Type::frameBuffer;
+    if (hasOption(argc, argv, "--drm"))
+    {
+        backendType = CursorBackend::Type::drm;
+    }
+    else if (hasOption(argc, argv, "--x11"))
+    {
+        backendType = CursorBackend::Type::x11;
+    }
+    CursorPainter painter(painterMode, backendType,
+            getThreadConfig(PAINTERD_CPU));
+    while(painter.getDisplayWidth() == 0)
+    {
+        sleep(1);
+    }
+    CursorTracker tracker(0, 0, painter.getDisplayWidth(),
+            painter.getDisplayHeight());
+    // Publish the cursor state for other local processes:
+    CursorPublisher publisher;
+    Coordinator coordinator(painter, tracker);
+    coordinator.setPublisher(&publisher);
+
+    // With --evdev, read input devices directly instead of launching the key
+    // daemon, falling back to the daemon if no devices can be read:
+    std::unique_ptr<EvdevListener> evdevListener;
+    std::unique_ptr<KeyListener> keyListener;
+    // Declared after all objects it reads, so it is destroyed first:
+    Stats::StatsFile statsFile(STATS_PATH, "CPICursor");
+    if (hasOption(argc, argv, "--evdev"))
+    {
+        evdevListener.reset(new EvdevListener(coordinator));
+        assignKeyCodes(*evdevListener);
+        if (evdevListener->startReading())
+        {
+            evdevListener->registerStats(statsFile);
+        }
+        else
+        {
+            std::cerr << "Reading input devices failed, starting the key "
+                    << "daemon instead.\n";
+            evdevListener.reset();
+        }
+    }
+    if (evdevListener == nullptr)
+    {
+        keyListener.reset(new KeyListener(coordinator));
+        assignKeyCodes(*keyListener);
+        keyListener->startKeyDaemon();
+        keyListener->registerStats(statsFile);
+        RealTime::configureProcess(keyListener->getDaemonProcessID(),
+                getThreadConfig(KEYD_CPU), "cursorKeyd");
+    }
+    coordinator.startUpdateLoop(60, getThreadConfig(COORDINATOR_CPU));
+    coordinator.registerStats(statsFile);
+    painter.registerStats(statsFile);
+    publisher.registerStats(statsFile);
+    statsFile.startWriting(STATS_INTERVAL_MS);
     sleep(30000);
     return 0;
 }
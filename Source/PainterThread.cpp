@@ -0,0 +1,142 @@
+#include "PainterThread.h"
+#include "AllocGuard.h"
+#include <chrono>
+
+// Initializes the cursor backend and starts the painter thread.
+PainterThread::PainterThread(const CursorBackend::Type backendType,
+        const RealTime::ThreadConfig threadConfig) :
+    PainterThread(CursorBackend::create(backendType, threadConfig),
+            threadConfig) { }
+
+
+// Starts a painter thread that draws using an existing cursor backend.
+PainterThread::PainterThread(std::unique_ptr<CursorBackend> backend,
+        const RealTime::ThreadConfig threadConfig, const std::string name) :
+    backend(std::move(backend)), cursorPos(noPosition),
+    cursorShape(CursorAtlas::Shape(0)), threadConfig(threadConfig),
+    name(name), framesDrawnName(name + "_frames_drawn"),
+    drawTimeTotalName(name + "_draw_time_total_ns"),
+    drawTimeMaxName(name + "_draw_time_max_ns")
+{
+    drawThread = std::thread([this]() { drawLoop(); });
+}
+
+
+// Stops the painter thread on destruction.
+PainterThread::~PainterThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(drawLock);
+        shouldStop = true;
+        drawCondition.notify_one();
+    }
+    drawThread.join();
+}
+
+
+// Sets the position where the painter thread should draw the cursor.
+void PainterThread::setCursorPos(const size_t x, const size_t y)
+{
+    cursorPos.store((static_cast<uint64_t>(x) << 32)
+            | static_cast<uint32_t>(y), std::memory_order_release);
+    std::lock_guard<std::mutex> lock(drawLock);
+    positionChanged = true;
+    drawCondition.notify_one();
+}
+
+
+// Sets the shape the painter thread should use to draw the cursor.
+void PainterThread::setShape(const CursorAtlas::Shape shape)
+{
+    cursorShape.store(shape, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(drawLock);
+    shapeChanged = true;
+    drawCondition.notify_one();
+}
+
+
+// Tells the painter thread to remove the cursor from the display until a new
+// position is set.
+void PainterThread::hideCursor()
+{
+    cursorPos.store(noPosition, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(drawLock);
+    positionChanged = true;
+    drawCondition.notify_one();
+}
+
+
+// Gets the display width in pixels.
+size_t PainterThread::getDisplayWidth() const
+{
+    return backend->getWidth();
+}
+
+
+// Gets the display height in pixels.
+size_t PainterThread::getDisplayHeight() const
+{
+    return backend->getHeight();
+}
+
+
+// Adds the performance counters of the PainterThread and its backend to a
+// stats file.
+void PainterThread::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter(framesDrawnName.c_str(), framesDrawn);
+    statsFile.addCounter(drawTimeTotalName.c_str(), drawTimeTotal);
+    statsFile.addCounter(drawTimeMaxName.c_str(), drawTimeMax);
+    backend->registerStats(statsFile);
+}
+
+
+// Draws the cursor each time its position or shape changes, running within the
+// painter thread.
+void PainterThread::drawLoop()
+{
+    using namespace std::chrono;
+    RealTime::configureThread(threadConfig, (name + " thread").c_str());
+    std::unique_lock<std::mutex> lock(drawLock);
+    while (! shouldStop)
+    {
+        ALLOC_GUARD_SCOPE
+        drawCondition.wait(lock, [this]()
+        {
+            return positionChanged || shapeChanged || shouldStop;
+        });
+        if (shouldStop)
+        {
+            return;
+        }
+        const bool shouldMove = positionChanged;
+        const bool shouldChangeShape = shapeChanged;
+        positionChanged = false;
+        shapeChanged = false;
+        lock.unlock();
+        const time_point<high_resolution_clock, nanoseconds> drawStart
+                = high_resolution_clock::now();
+        if (shouldChangeShape)
+        {
+            backend->setShape(cursorShape.load(std::memory_order_acquire));
+        }
+        if (shouldMove)
+        {
+            const uint64_t position
+                    = cursorPos.load(std::memory_order_acquire);
+            if (position == noPosition)
+            {
+                backend->hideCursor();
+            }
+            else
+            {
+                backend->drawCursor(position >> 32, position & UINT32_MAX);
+            }
+        }
+        const nanoseconds drawTime = high_resolution_clock::now() - drawStart;
+        framesDrawn.add();
+        drawTimeTotal.add(drawTime.count());
+        drawTimeMax.recordMax(drawTime.count());
+        lock.lock();
+    }
+}
@@ -0,0 +1,146 @@
+/**
+ * @file  PainterThread.h
+ *
+ * @brief  Draws the cursor from a dedicated thread within CPICursor, as an
+ *         alternative to the cursor painter daemon.
+ *
+ *  Cursor positions are handed to the painter thread through a single atomic
+ * value, so the thread always draws the most recent position and never needs
+ * to queue or copy points. Drawing directly to the display requires CPICursor
+ * to have frame buffer or DRM access, so the daemon should be used when
+ * CPICursor runs without elevated privileges.
+ *
+ *  cursorPainterd also uses one PainterThread for each display when drawing
+ * to several frame buffers, so that a slow display only delays itself.
+ */
+
+#pragma once
+#include "CursorBackend.h"
+#include "RealTime.h"
+#include "Stats.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class PainterThread
+{
+public:
+    /**
+     * @brief  Initializes the cursor backend and starts the painter thread.
+     *
+     * @param backendType   The type of cursor backend to use.
+     *
+     * @param threadConfig  Scheduling options to apply to the painter thread.
+     */
+    PainterThread(const CursorBackend::Type backendType,
+            const RealTime::ThreadConfig threadConfig);
+
+    /**
+     * @brief  Starts a painter thread that draws using an existing cursor
+     *         backend.
+     *
+     * @param backend       The backend the thread will draw with.
+     *
+     * @param threadConfig  Scheduling options to apply to the painter thread.
+     *
+     * @param name          The name used for the thread's performance
+     *                      counters and error messages.
+     */
+    PainterThread(std::unique_ptr<CursorBackend> backend,
+            const RealTime::ThreadConfig threadConfig,
+            const std::string name = "painter");
+
+    /**
+     * @brief  Stops the painter thread on destruction.
+     */
+    virtual ~PainterThread();
+
+    /**
+     * @brief  Sets the position where the painter thread should draw the
+     *         cursor.
+     *
+     * @param x  Screen x-coordinate, measured in pixels.
+     *
+     * @param y  Screen y-coordinate, measured in pixels.
+     */
+    void setCursorPos(const size_t x, const size_t y);
+
+    /**
+     * @brief  Sets the shape the painter thread should use to draw the
+     *         cursor.
+     *
+     * @param shape  The new cursor shape.
+     */
+    void setShape(const CursorAtlas::Shape shape);
+
+    /**
+     * @brief  Tells the painter thread to remove the cursor from the display
+     *         until a new position is set.
+     */
+    void hideCursor();
+
+    /**
+     * @brief  Gets the display width in pixels.
+     *
+     * @return  The display width.
+     */
+    size_t getDisplayWidth() const;
+
+    /**
+     * @brief  Gets the display height in pixels.
+     *
+     * @return  The display height.
+     */
+    size_t getDisplayHeight() const;
+
+    /**
+     * @brief  Adds the performance counters of the PainterThread and its
+     *         backend to a stats file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
+private:
+    /**
+     * @brief  Draws the cursor each time its position or shape changes,
+     *         running within the painter thread.
+     */
+    void drawLoop();
+
+    // Value of cursorPos when no position has been set, or the cursor
+    // should be hidden:
+    static const constexpr uint64_t noPosition = UINT64_MAX;
+
+    // Puts the cursor on the display:
+    std::unique_ptr<CursorBackend> backend;
+    // The latest cursor position, with x in the upper 32 bits and y in the
+    // lower 32 bits:
+    std::atomic<uint64_t> cursorPos;
+    // The latest cursor shape:
+    std::atomic<CursorAtlas::Shape> cursorShape;
+    // Wakes the painter thread when the position or shape changes, or it
+    // should stop:
+    std::mutex drawLock;
+    std::condition_variable drawCondition;
+    bool positionChanged = false;
+    bool shapeChanged = false;
+    bool shouldStop = false;
+    // Scheduling options for the painter thread:
+    const RealTime::ThreadConfig threadConfig;
+    // Names used for the thread and its performance counters:
+    const std::string name;
+    const std::string framesDrawnName;
+    const std::string drawTimeTotalName;
+    const std::string drawTimeMaxName;
+    std::thread drawThread;
+    // Counts frames drawn:
+    Stats::Counter framesDrawn;
+    // Total and maximum time spent drawing a single frame:
+    Stats::Counter drawTimeTotal;
+    Stats::Counter drawTimeMax;
+};
@@ -0,0 +1,243 @@
+#include "RealTime.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <linux/capability.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Amount of stack memory to prefault when locking memory:
+static const constexpr size_t stackPrefaultSize = 64 * 1024;
+
+
+// Gets the scheduling policy matching a policy name.
+RealTime::Policy RealTime::parsePolicy(const char* name)
+{
+    if (strcmp(name, "fifo") == 0)
+    {
+        return Policy::fifo;
+    }
+    if (strcmp(name, "rr") == 0)
+    {
+        return Policy::roundRobin;
+    }
+    return Policy::normal;
+}
+
+
+// Gets the Linux scheduling policy value for a Policy.
+static int getPolicyValue(const RealTime::Policy policy)
+{
+    switch (policy)
+    {
+        case RealTime::Policy::fifo:
+            return SCHED_FIFO;
+        case RealTime::Policy::roundRobin:
+            return SCHED_RR;
+        default:
+            return SCHED_OTHER;
+    }
+}
+
+
+// Builds a scheduling parameter structure for a ThreadConfig, clamping the
+// priority to the range supported by its policy.
+static struct sched_param getSchedParam(const RealTime::ThreadConfig& config)
+{
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    const int policy = getPolicyValue(config.policy);
+    if (config.policy != RealTime::Policy::normal)
+    {
+        const int minPriority = sched_get_priority_min(policy);
+        const int maxPriority = sched_get_priority_max(policy);
+        param.sched_priority = config.priority;
+        if (param.sched_priority < minPriority)
+        {
+            param.sched_priority = minPriority;
+        }
+        else if (param.sched_priority > maxPriority)
+        {
+            param.sched_priority = maxPriority;
+        }
+    }
+    return param;
+}
+
+
+// Prints a warning when a scheduling option could not be applied.
+static void printWarning(const char* name, const char* action, const int error)
+{
+    fprintf(stderr, "RealTime: Unable to %s for %s: %s\n", action, name,
+            strerror(error));
+}
+
+
+// Applies scheduling options to the calling thread.
+bool RealTime::configureThread(const ThreadConfig& config, const char* name)
+{
+    bool succeeded = true;
+    if (config.policy != Policy::normal)
+    {
+        const struct sched_param param = getSchedParam(config);
+        const int result = pthread_setschedparam(pthread_self(),
+                getPolicyValue(config.policy), &param);
+        if (result != 0)
+        {
+            printWarning(name, "set real-time priority", result);
+            succeeded = false;
+        }
+    }
+    if (config.cpu >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(config.cpu, &cpuSet);
+        const int result = pthread_setaffinity_np(pthread_self(),
+                sizeof(cpuSet), &cpuSet);
+        if (result != 0)
+        {
+            printWarning(name, "set CPU affinity", result);
+            succeeded = false;
+        }
+    }
+    return succeeded;
+}
+
+
+// Applies scheduling options to the main thread of another process.
+bool RealTime::configureProcess
+(const pid_t processID, const ThreadConfig& config, const char* name)
+{
+    if (processID <= 0)
+    {
+        return false;
+    }
+    bool succeeded = true;
+    if (config.policy != Policy::normal)
+    {
+        const struct sched_param param = getSchedParam(config);
+        if (sched_setscheduler(processID, getPolicyValue(config.policy),
+                &param) != 0)
+        {
+            printWarning(name, "set real-time priority", errno);
+            succeeded = false;
+        }
+    }
+    if (config.cpu >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(config.cpu, &cpuSet);
+        if (sched_setaffinity(processID, sizeof(cpuSet), &cpuSet) != 0)
+        {
+            printWarning(name, "set CPU affinity", errno);
+            succeeded = false;
+        }
+    }
+    return succeeded;
+}
+
+
+// Touches each page of a block of stack memory so that it is faulted in before
+// it is needed.
+static void prefaultStack()
+{
+    volatile unsigned char stackBlock [stackPrefaultSize];
+    for (size_t i = 0; i < stackPrefaultSize; i += 4096)
+    {
+        stackBlock[i] = 0;
+    }
+    (void) stackBlock;
+}
+
+
+// Checks if the process may lock any amount of memory, either because
+// RLIMIT_MEMLOCK is unlimited or because it has the CAP_IPC_LOCK capability.
+static bool canLockUnlimitedMemory()
+{
+    struct rlimit lockLimit;
+    if (getrlimit(RLIMIT_MEMLOCK, &lockLimit) == 0
+            && lockLimit.rlim_cur == RLIM_INFINITY)
+    {
+        return true;
+    }
+    struct __user_cap_header_struct capHeader;
+    struct __user_cap_data_struct capData [_LINUX_CAPABILITY_U32S_3];
+    memset(&capHeader, 0, sizeof(capHeader));
+    memset(capData, 0, sizeof(capData));
+    capHeader.version = _LINUX_CAPABILITY_VERSION_3;
+    capHeader.pid = 0;
+    if (syscall(SYS_capget, &capHeader, capData) != 0)
+    {
+        return false;
+    }
+    return (capData[CAP_TO_INDEX(CAP_IPC_LOCK)].effective
+            & CAP_TO_MASK(CAP_IPC_LOCK)) != 0;
+}
+
+
+// Locks current process memory into RAM, along with all future memory if the
+// memory lock limit allows it, and prefaults the calling thread's stack.
+bool RealTime::lockMemory()
+{
+    // With a limited RLIMIT_MEMLOCK, locking future memory makes every later
+    // mapping count against the limit, so creating thread stacks would fail:
+    const bool lockFutureMemory = canLockUnlimitedMemory();
+    if (mlockall(lockFutureMemory ? (MCL_CURRENT | MCL_FUTURE) : MCL_CURRENT)
+            != 0)
+    {
+        printWarning("process memory", "lock", errno);
+        return false;
+    }
+    if (! lockFutureMemory)
+    {
+        fprintf(stderr, "RealTime: Memory lock limit is too low to lock "
+                "future memory, so only current memory was locked.\n");
+    }
+    prefaultStack();
+    return true;
+}
+
+
+// Records a single wake-up.
+void RealTime::JitterStats::addSample(const std::chrono::nanoseconds lateness)
+{
+    const uint64_t sample = (lateness.count() > 0) ? lateness.count() : 0;
+    sampleCount.fetch_add(1, std::memory_order_relaxed);
+    totalNanoseconds.fetch_add(sample, std::memory_order_relaxed);
+    if (sample > maxNanoseconds.load(std::memory_order_relaxed))
+    {
+        maxNanoseconds.store(sample, std::memory_order_relaxed);
+    }
+}
+
+
+// Gets the number of recorded wake-ups.
+uint64_t RealTime::JitterStats::getSampleCount() const
+{
+    return sampleCount.load(std::memory_order_relaxed);
+}
+
+
+// Gets the largest recorded wake-up delay.
+uint64_t RealTime::JitterStats::getMaxNanoseconds() const
+{
+    return maxNanoseconds.load(std::memory_order_relaxed);
+}
+
+
+// Gets the average recorded wake-up delay.
+uint64_t RealTime::JitterStats::getMeanNanoseconds() const
+{
+    const uint64_t count = getSampleCount();
+    if (count == 0)
+    {
+        return 0;
+    }
+    return totalNanoseconds.load(std::memory_order_relaxed) / count;
+}
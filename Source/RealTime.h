@@ -0,0 +1,148 @@
+/**
+ * @file  RealTime.h
+ *
+ * @brief  Applies real-time scheduling, CPU affinity, and memory locking to
+ *         the threads and processes in the cursor pipeline, and measures the
+ *         scheduling jitter that results.
+ *
+ *  All functions here are best-effort: when the process lacks the privileges
+ * needed to change scheduling or lock memory, they print a warning and return
+ * false, leaving the process running with default scheduling.
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace RealTime
+{
+    /**
+     * @brief  Lists the scheduling policies that may be applied.
+     */
+    enum class Policy
+    {
+        // Leave the default (SCHED_OTHER) policy unchanged:
+        normal,
+        // SCHED_FIFO:
+        fifo,
+        // SCHED_RR:
+        roundRobin
+    };
+
+    /**
+     * @brief  Gets the scheduling policy matching a policy name.
+     *
+     * @param name  One of "fifo", "rr", or "none".
+     *
+     * @return      The matching policy, or Policy::normal if the name is not
+     *              recognized.
+     */
+    Policy parsePolicy(const char* name);
+
+    /**
+     * @brief  Scheduling options for a single thread or process.
+     */
+    struct ThreadConfig
+    {
+        // Scheduling policy to apply:
+        Policy policy = Policy::normal;
+        // Real-time priority, ignored when policy is Policy::normal:
+        int priority = 0;
+        // CPU core to pin to, or a negative value to leave affinity unchanged:
+        int cpu = -1;
+    };
+
+    /**
+     * @brief  Applies scheduling options to the calling thread.
+     *
+     * @param config  The scheduling options to apply.
+     *
+     * @param name    A thread name to print in warning messages.
+     *
+     * @return        Whether all options were applied successfully.
+     */
+    bool configureThread(const ThreadConfig& config, const char* name);
+
+    /**
+     * @brief  Applies scheduling options to the main thread of another
+     *         process.
+     *
+     * @param processID  The ID of the process to configure.
+     *
+     * @param config     The scheduling options to apply.
+     *
+     * @param name       A process name to print in warning messages.
+     *
+     * @return           Whether all options were applied successfully.
+     */
+    bool configureProcess(const pid_t processID, const ThreadConfig& config,
+            const char* name);
+
+    /**
+     * @brief  Locks all current and future process memory into RAM, and
+     *         prefaults the calling thread's stack.
+     *
+     *  Memory mapped after this call, including thread stacks and frame
+     * buffer mappings, is locked and populated as it is mapped, so this should
+     * be called before starting threads or opening display devices. Future
+     * memory is only locked when RLIMIT_MEMLOCK is unlimited or the process
+     * has CAP_IPC_LOCK. Otherwise, every later mapping would count against
+     * the limit, and new threads would fail to allocate their stacks, so only
+     * current memory is locked.
+     *
+     * @return  Whether memory was successfully locked.
+     */
+    bool lockMemory();
+
+    /**
+     * @brief  Records how late a periodic loop wakes up compared to its
+     *         scheduled time.
+     *
+     *  Samples should only be added from a single thread, but values may be
+     * read from any thread.
+     */
+    class JitterStats
+    {
+    public:
+        JitterStats() { }
+
+        virtual ~JitterStats() { }
+
+        /**
+         * @brief  Records a single wake-up.
+         *
+         * @param lateness  Time between the scheduled wake-up time and the
+         *                  actual wake-up time.
+         */
+        void addSample(const std::chrono::nanoseconds lateness);
+
+        /**
+         * @brief  Gets the number of recorded wake-ups.
+         *
+         * @return  The total sample count.
+         */
+        uint64_t getSampleCount() const;
+
+        /**
+         * @brief  Gets the largest recorded wake-up delay.
+         *
+         * @return  The maximum lateness in nanoseconds.
+         */
+        uint64_t getMaxNanoseconds() const;
+
+        /**
+         * @brief  Gets the average recorded wake-up delay.
+         *
+         * @return  The mean lateness in nanoseconds, or zero if no samples
+         *          were recorded.
+         */
+        uint64_t getMeanNanoseconds() const;
+
+    private:
+        std::atomic<uint64_t> sampleCount { 0 };
+        std::atomic<uint64_t> totalNanoseconds { 0 };
+        std::atomic<uint64_t> maxNanoseconds { 0 };
+    };
+}
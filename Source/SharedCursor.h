@@ -0,0 +1,238 @@
+/**
+ * @file  SharedCursor.h
+ *
+ * @brief  Defines the shared memory segment where CPICursor publishes the
+ *         cursor state, and a header-only reader for other local processes.
+ *
+ *  While running, CPICursor keeps the cursor position, click button state,
+ * and an update count in the POSIX shared memory object named by
+ * SharedCursor::segmentName, found at /dev/shm/CPICursor on Linux. Other
+ * processes may map it read-only and poll it as often as they like: reading
+ * the cursor state only takes a few memory loads and no system calls or extra
+ * work for CPICursor. CPICursor usually exits without clearing its active
+ * flag, so reads may keep returning its last state after it stops. The
+ * segment also holds its process ID, and readers that need to notice when
+ * CPICursor stops should occasionally call Reader::isActive, which checks
+ * that the process still exists with a single system call.
+ *
+ *  The segment is protected by a sequence lock. The sequence value is odd
+ * while CPICursor is writing, and increases by two with each update. Readers
+ * copy the cursor state between two reads of the sequence value, and retry if
+ * the value changed or was odd.
+ *
+ *  This file has no dependencies outside of the standard library and POSIX,
+ * so client programs may copy it directly. Linking with -lrt may be needed
+ * for shm_open on older C libraries.
+ */
+
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SharedCursor
+{
+    // The name of the shared memory object holding the cursor state:
+    static const constexpr char* segmentName = "/CPICursor";
+
+    // Identifies a valid cursor state segment:
+    static const constexpr uint32_t segmentMagic = 0x43504943;
+
+    // Changes whenever the segment layout changes:
+    static const constexpr uint32_t segmentVersion = 2;
+
+    // Bits set in the button state while each click key is held down:
+    static const constexpr uint32_t leftButton = 1 << 0;
+    static const constexpr uint32_t rightButton = 1 << 1;
+
+    static_assert(ATOMIC_INT_LOCK_FREE == 2,
+            "Shared cursor state requires lock-free 32-bit atomics.");
+
+    /**
+     * @brief  The layout of the shared memory segment. All values are
+     *         accessed through atomic operations, so they stay valid when
+     *         shared between processes.
+     */
+    struct Segment
+    {
+        // Always equal to segmentMagic once the segment is initialized:
+        std::atomic<uint32_t> magic;
+        // The segmentVersion used by CPICursor:
+        std::atomic<uint32_t> version;
+        // Set to 1 while CPICursor is publishing, and 0 once it exits:
+        std::atomic<uint32_t> active;
+        // Sequence lock value, odd while an update is being written:
+        std::atomic<uint32_t> sequence;
+        // Cursor position, in display pixels:
+        std::atomic<uint32_t> x;
+        std::atomic<uint32_t> y;
+        // Bitmask of held click buttons:
+        std::atomic<uint32_t> buttons;
+        // Process ID of the CPICursor process publishing the segment:
+        std::atomic<uint32_t> publisherID;
+    };
+
+    /**
+     * @brief  A consistent copy of the published cursor state.
+     */
+    struct CursorState
+    {
+        // Number of updates published so far. Readers may compare this with
+        // the last value they read to check if anything changed:
+        uint32_t updateCount;
+        // Cursor position, in display pixels:
+        uint32_t x;
+        uint32_t y;
+        // Bitmask of held click buttons:
+        uint32_t buttons;
+    };
+
+    /**
+     * @brief  Maps the shared cursor state segment read-only, and reads
+     *         consistent copies of the cursor state.
+     */
+    class Reader
+    {
+    public:
+        /**
+         * @brief  Opens and maps the shared cursor state if it exists.
+         *
+         * @param name  The shared memory object name.
+         */
+        Reader(const char* name = segmentName)
+        {
+            const int fileDescriptor = shm_open(name, O_RDONLY | O_CLOEXEC,
+                    0);
+            if (fileDescriptor < 0)
+            {
+                return;
+            }
+            // The segment is empty until CPICursor finishes sizing it, and
+            // reading past its end would raise SIGBUS:
+            struct stat segmentInfo;
+            if (fstat(fileDescriptor, &segmentInfo) != 0
+                    || segmentInfo.st_size < (off_t) sizeof(Segment))
+            {
+                close(fileDescriptor);
+                return;
+            }
+            void* mapping = mmap(nullptr, sizeof(Segment), PROT_READ,
+                    MAP_SHARED, fileDescriptor, 0);
+            close(fileDescriptor);
+            if (mapping != MAP_FAILED)
+            {
+                segment = static_cast<const Segment*>(mapping);
+            }
+        }
+
+        /**
+         * @brief  Unmaps the shared cursor state on destruction.
+         */
+        ~Reader()
+        {
+            if (segment != nullptr)
+            {
+                munmap(const_cast<Segment*>(segment), sizeof(Segment));
+            }
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        /**
+         * @brief  Checks if the segment was mapped, and is still being
+         *         published by a running CPICursor process. Unlike read, this
+         *         makes a system call. If CPICursor restarts, readers must be
+         *         recreated to map its new segment.
+         *
+         * @return  Whether the cursor state may be read.
+         */
+        bool isActive() const
+        {
+            return isValid() && isPublisherRunning();
+        }
+
+        /**
+         * @brief  Copies the current cursor state.
+         *
+         * @param state  Used to return the cursor state.
+         *
+         * @return       Whether a consistent cursor state was read. This
+         *               fails if the segment is marked inactive, or if it was
+         *               being updated on every attempt. If CPICursor stopped
+         *               without clearing its active flag, this keeps
+         *               returning its last cursor state.
+         */
+        bool read(CursorState& state) const
+        {
+            if (! isValid())
+            {
+                return false;
+            }
+            for (int attempt = 0; attempt < maxReadAttempts; attempt++)
+            {
+                const uint32_t start
+                        = segment->sequence.load(std::memory_order_acquire);
+                if ((start & 1) != 0)
+                {
+                    continue;
+                }
+                state.x = segment->x.load(std::memory_order_relaxed);
+                state.y = segment->y.load(std::memory_order_relaxed);
+                state.buttons
+                        = segment->buttons.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (segment->sequence.load(std::memory_order_relaxed)
+                        == start)
+                {
+                    state.updateCount = start / 2;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        /**
+         * @brief  Checks if the segment was mapped, fully initialized, and
+         *         not marked inactive, without any system calls.
+         *
+         * @return  Whether the segment holds valid cursor state.
+         */
+        bool isValid() const
+        {
+            return segment != nullptr
+                    && segment->magic.load(std::memory_order_acquire)
+                        == segmentMagic
+                    && segment->version.load(std::memory_order_relaxed)
+                        == segmentVersion
+                    && segment->active.load(std::memory_order_relaxed) == 1;
+        }
+
+        /**
+         * @brief  Checks if the process that published the segment still
+         *         exists.
+         *
+         * @return  Whether the publisher is running.
+         */
+        bool isPublisherRunning() const
+        {
+            const pid_t publisherID = static_cast<pid_t>(
+                    segment->publisherID.load(std::memory_order_relaxed));
+            // EPERM means the process exists, but belongs to another user:
+            return publisherID > 0
+                    && (kill(publisherID, 0) == 0 || errno == EPERM);
+        }
+
+        // Number of times to retry reading before giving up:
+        static const constexpr int maxReadAttempts = 1000;
+        // The mapped cursor state, or nullptr if mapping failed:
+        const Segment* segment = nullptr;
+    };
+}
@@ -0,0 +1,149 @@
+#include "Stats.h"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Maximum size of the stats file:
+static const constexpr size_t maxFileSize = 4096;
+// Maximum length of the stats file path:
+static const constexpr size_t maxPathLength = 512;
+// Name of the value listing how many values didn't fit in the stats file:
+static const constexpr char* droppedValuesName = "stats_values_dropped";
+
+
+// Saves the stats file path and line prefix on construction.
+Stats::StatsFile::StatsFile(const char* path, const char* prefix) :
+    path(path), prefix(prefix) { }
+
+
+// Stops the writing thread and removes the stats file.
+Stats::StatsFile::~StatsFile()
+{
+    if (writeThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(writeLock);
+            shouldStop = true;
+            writeCondition.notify_one();
+        }
+        writeThread.join();
+        unlink(path);
+    }
+}
+
+
+// Adds a counter to the stats file.
+void Stats::StatsFile::addCounter(const char* name, const Counter& counter)
+{
+    entries.push_back({ name, &counter, nullptr });
+}
+
+
+// Adds a set of jitter statistics to the stats file.
+void Stats::StatsFile::addJitter
+(const char* name, const RealTime::JitterStats& jitter)
+{
+    entries.push_back({ name, nullptr, &jitter });
+}
+
+
+// Starts writing the stats file in a new thread, if it is not already being
+// written.
+void Stats::StatsFile::startWriting(const int intervalMs)
+{
+    if (writeThread.joinable())
+    {
+        return;
+    }
+    writeThread = std::thread([this, intervalMs]()
+    {
+        std::unique_lock<std::mutex> lock(writeLock);
+        while (! shouldStop)
+        {
+            writeFile();
+            writeCondition.wait_for(lock,
+                    std::chrono::milliseconds(intervalMs),
+                    [this]() { return shouldStop; });
+        }
+    });
+}
+
+
+// Writes all values to a temporary file, then moves it over the stats file.
+bool Stats::StatsFile::writeFile()
+{
+    char buffer [maxFileSize];
+    size_t length = 0;
+    // Only whole lines are written. Once a value doesn't fit, it and all
+    // values after it are left out and counted, keeping enough space free to
+    // list how many were dropped:
+    size_t valuesDropped = 0;
+    const size_t maxValueCount = entries.size() * 3;
+    const int droppedLineLength = snprintf(nullptr, 0, "%s.%s %zu\n",
+            prefix, droppedValuesName, maxValueCount);
+    const size_t lineLimit = (droppedLineLength > 0
+            && (size_t) droppedLineLength < maxFileSize)
+            ? (maxFileSize - droppedLineLength) : 0;
+    const auto addLine = [&buffer, &length, &valuesDropped, lineLimit, this]
+        (const char* name, const char* suffix, const uint64_t value)
+    {
+        const size_t spaceLeft = (valuesDropped == 0 && length < lineLimit)
+                ? (lineLimit - length) : 0;
+        const int lineLength = snprintf(buffer + length, spaceLeft,
+                "%s.%s%s %" PRIu64 "\n", prefix, name, suffix, value);
+        // snprintf also needs space for a null terminator, so lines that
+        // fill all remaining space were cut short:
+        if (lineLength > 0 && (size_t) lineLength < spaceLeft)
+        {
+            length += lineLength;
+        }
+        else
+        {
+            valuesDropped++;
+        }
+    };
+    for (const Entry& entry : entries)
+    {
+        if (entry.counter != nullptr)
+        {
+            addLine(entry.name, "", entry.counter->get());
+        }
+        else
+        {
+            addLine(entry.name, "_samples", entry.jitter->getSampleCount());
+            addLine(entry.name, "_mean_ns",
+                    entry.jitter->getMeanNanoseconds());
+            addLine(entry.name, "_max_ns", entry.jitter->getMaxNanoseconds());
+        }
+    }
+    if (valuesDropped > 0 && lineLimit > 0)
+    {
+        length += snprintf(buffer + length, maxFileSize - length,
+                "%s.%s %zu\n", prefix, droppedValuesName, valuesDropped);
+    }
+
+    char tempPath [maxPathLength];
+    if (snprintf(tempPath, maxPathLength, "%s.tmp", path)
+            >= (int) maxPathLength)
+    {
+        return false;
+    }
+    const int fileDescriptor = open(tempPath,
+            O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+    const bool written = (write(fileDescriptor, buffer, length)
+            == (ssize_t) length);
+    close(fileDescriptor);
+    if (! written || rename(tempPath, path) != 0)
+    {
+        unlink(tempPath);
+        return false;
+    }
+    return true;
+}
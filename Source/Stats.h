@@ -0,0 +1,151 @@
+/**
+ * @file  Stats.h
+ *
+ * @brief  Lock-free performance counters, and a stats file that periodically
+ *         publishes them in a simple text format.
+ *
+ *  Each line of the stats file holds a single "<prefix>.<name> <value>" pair,
+ * listed in the order that values were added to the file. Jitter statistics
+ * are expanded into "<name>_samples", "<name>_mean_ns", and "<name>_max_ns"
+ * lines. The file is replaced atomically on each update, so it may be read
+ * at any time. Only whole lines are written: once the maximum file size is
+ * reached, the remaining values are left out, and their number is listed in a
+ * final "<prefix>.stats_values_dropped" line.
+ */
+
+#pragma once
+#include "RealTime.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Stats
+{
+    /**
+     * @brief  A single lock-free performance counter.
+     */
+    class Counter
+    {
+    public:
+        Counter() { }
+
+        virtual ~Counter() { }
+
+        /**
+         * @brief  Adds to the counter's value.
+         *
+         * @param amount  The amount to add.
+         */
+        inline void add(const uint64_t amount = 1)
+        {
+            value.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief  Replaces the counter's value if a new value is larger. This
+         *         should only be called from a single thread.
+         *
+         * @param newValue  The value to compare against the current value.
+         */
+        inline void recordMax(const uint64_t newValue)
+        {
+            if (newValue > value.load(std::memory_order_relaxed))
+            {
+                value.store(newValue, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief  Gets the counter's current value.
+         *
+         * @return  The value stored in the counter.
+         */
+        inline uint64_t get() const
+        {
+            return value.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint64_t> value { 0 };
+    };
+
+    /**
+     * @brief  Periodically writes a set of counters to a stats file from a
+     *         dedicated thread.
+     */
+    class StatsFile
+    {
+    public:
+        /**
+         * @brief  Saves the stats file path and line prefix on construction.
+         *
+         * @param path    The path where the stats file will be written.
+         *
+         * @param prefix  The prefix added to each value name.
+         */
+        StatsFile(const char* path, const char* prefix);
+
+        /**
+         * @brief  Stops the writing thread and removes the stats file.
+         */
+        virtual ~StatsFile();
+
+        /**
+         * @brief  Adds a counter to the stats file. All counters must be added
+         *         before writing starts, and must remain valid until the
+         *         StatsFile is destroyed.
+         *
+         * @param name     The name used to label the counter's value.
+         *
+         * @param counter  The counter to add.
+         */
+        void addCounter(const char* name, const Counter& counter);
+
+        /**
+         * @brief  Adds a set of jitter statistics to the stats file, following
+         *         the same rules as addCounter.
+         *
+         * @param name    The name used to label the jitter values.
+         *
+         * @param jitter  The jitter statistics to add.
+         */
+        void addJitter(const char* name, const RealTime::JitterStats& jitter);
+
+        /**
+         * @brief  Starts writing the stats file in a new thread, if it is not
+         *         already being written.
+         *
+         * @param intervalMs  Milliseconds to wait between stats file updates.
+         */
+        void startWriting(const int intervalMs);
+
+    private:
+        /**
+         * @brief  Writes all values to a temporary file, then moves it over the
+         *         stats file.
+         *
+         * @return  Whether the stats file was updated successfully.
+         */
+        bool writeFile();
+
+        // A single value written to the file:
+        struct Entry
+        {
+            const char* name;
+            const Counter* counter;
+            const RealTime::JitterStats* jitter;
+        };
+
+        const char* path;
+        const char* prefix;
+        std::vector<Entry> entries;
+        std::thread writeThread;
+        // Wakes the writing thread early when it should stop:
+        std::mutex writeLock;
+        std::condition_variable writeCondition;
+        bool shouldStop = false;
+    };
+}
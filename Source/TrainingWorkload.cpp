@@ -0,0 +1,226 @@
+#include "TrainingWorkload.h"
+#include "AllocGuard.h"
+#include "Coordinator.h"
+#include "CursorPainter.h"
+#include "CursorTracker.h"
+#include "FrameBufferPainter.h"
+#include "DrawWorkload.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <time.h>
+#include <unistd.h>
+
+// Number of frames in the generated key trace:
+static const constexpr size_t traceFrameCount = 2000;
+// Number of key trace frames replayed with real key input timing:
+static const constexpr size_t liveFrameCount = 500;
+// Time between key trace frames when replaying with real timing:
+static const constexpr long liveFrameNanoseconds = 4000000;
+// Number of times the key trace is replayed when measuring key handling:
+static const constexpr size_t keyReplayCount = 500;
+// Number of key trace frames replayed before counting allocations:
+static const constexpr size_t allocWarmupFrameCount = 250;
+// Seeds used to generate the training and benchmark key traces:
+static const constexpr uint32_t trainingSeed = 0x43504943;
+static const constexpr uint32_t benchmarkSeed = 0x42454e43;
+// Number of Key types used in the trace, skipping Key::exit:
+static const constexpr uint32_t traceKeyCount = 6;
+
+// Opens the frame buffer drawn to by the workload, printing an error and
+// returning null if it can't be used.
+static std::unique_ptr<CursorBackend> openFrameBuffer(const char* path)
+{
+    std::unique_ptr<CursorBackend> frameBuffer;
+    if (access(path, R_OK | W_OK) == 0)
+    {
+        frameBuffer.reset(new FrameBufferPainter(path));
+    }
+    if (frameBuffer == nullptr || frameBuffer->getWidth() == 0)
+    {
+        fprintf(stderr, "TrainingWorkload: Can't draw to frame buffer "
+                "\"%s\".\n", path);
+        frameBuffer.reset();
+    }
+    return frameBuffer;
+}
+
+
+// Generates the key trace on construction.
+TrainingWorkload::TrainingWorkload(const Trace trace) : trace(trace)
+{
+    // A simple linear congruential generator keeps the trace identical
+    // across runs, builds, and standard library versions:
+    uint32_t randomState = (trace == Trace::training)
+            ? trainingSeed : benchmarkSeed;
+    const auto nextRandom = [&randomState]()
+    {
+        randomState = randomState * 1664525 + 1013904223;
+        return randomState >> 8;
+    };
+    bool keyHeld [traceKeyCount] = {false};
+    for (size_t frame = 0; frame < traceFrameCount; frame++)
+    {
+        const size_t frameSize = 1 + (nextRandom() % 2);
+        for (size_t i = 0; i < frameSize; i++)
+        {
+            const uint32_t keyIndex = nextRandom() % traceKeyCount;
+            KeyListener::KeyEvent event;
+            event.key = static_cast<KeyListener::Key>(keyIndex);
+            if (! keyHeld[keyIndex])
+            {
+                event.actionType = KeyDaemon::EventType::pressed;
+                keyHeld[keyIndex] = true;
+            }
+            else if ((nextRandom() % 4) != 0)
+            {
+                event.actionType = KeyDaemon::EventType::held;
+            }
+            else
+            {
+                event.actionType = KeyDaemon::EventType::released;
+                keyHeld[keyIndex] = false;
+            }
+            traceEvents.push_back(event);
+        }
+        frameSizes.push_back(frameSize);
+    }
+}
+
+
+// Runs all workload stages, printing each measured time to standard output.
+int TrainingWorkload::run(const char* frameBufferPath)
+{
+    const char* const prefix = (trace == Trace::training) ? "train" : "bench";
+    // Run the full input to drawing pipeline, so that thread handoff and
+    // update loop code is also profiled:
+    {
+        std::unique_ptr<CursorBackend> frameBuffer
+                = openFrameBuffer(frameBufferPath);
+        if (frameBuffer == nullptr)
+        {
+            return 1;
+        }
+        CursorPainter painter(std::move(frameBuffer));
+        CursorTracker tracker(0, 0, painter.getDisplayWidth(),
+                painter.getDisplayHeight());
+        Coordinator coordinator(painter, tracker);
+        coordinator.startUpdateLoop(60);
+        replayLive(coordinator, liveFrameCount);
+    }
+
+    // Measure key handling separately, without the update loop competing for
+    // the tracker:
+    {
+        std::unique_ptr<CursorBackend> frameBuffer
+                = openFrameBuffer(frameBufferPath);
+        if (frameBuffer == nullptr)
+        {
+            return 1;
+        }
+        CursorPainter painter(std::move(frameBuffer));
+        CursorTracker tracker(0, 0, painter.getDisplayWidth(),
+                painter.getDisplayHeight());
+        Coordinator coordinator(painter, tracker);
+        printf("%s.key_frame_ns %.1f\n", prefix,
+                measureKeyHandling(coordinator, tracker));
+    }
+
+    std::unique_ptr<CursorBackend> frameBuffer
+            = openFrameBuffer(frameBufferPath);
+    if (frameBuffer == nullptr)
+    {
+        return 1;
+    }
+    const DrawWorkload::Path drawPath = (trace == Trace::training)
+            ? DrawWorkload::Path::training : DrawWorkload::Path::benchmark;
+    printf("%s.draw_frame_ns %.1f\n", prefix, DrawWorkload::run(*frameBuffer,
+            DrawWorkload::defaultFrameCount, false, drawPath));
+    return 0;
+}
+
+
+// Replays the key trace through the full input to drawing pipeline, checking
+// that no heap memory is allocated after the first frames warm it up.
+int TrainingWorkload::checkAllocations()
+{
+#if ! ALLOC_CHECK
+    fprintf(stderr, "TrainingWorkload: Allocations are only counted in "
+            "ALLOC_CHECK=1 builds.\n");
+    return 1;
+#else
+    CursorPainter painter(CursorPainter::Mode::thread,
+            CursorBackend::Type::offscreen);
+    CursorTracker tracker(0, 0, painter.getDisplayWidth(),
+            painter.getDisplayHeight());
+    Coordinator coordinator(painter, tracker);
+    coordinator.startUpdateLoop(60);
+    replayLive(coordinator, allocWarmupFrameCount);
+    // Guard scopes abort on allocations within the steady-state code paths,
+    // and the allocation count also catches any made outside of them:
+    const uint64_t startCount = AllocGuard::getAllocationCount();
+    replayLive(coordinator, frameSizes.size());
+    const uint64_t allocations = AllocGuard::getAllocationCount()
+            - startCount;
+    printf("alloc_check.allocations %llu\n",
+            static_cast<unsigned long long>(allocations));
+    return (allocations == 0) ? 0 : 1;
+#endif
+}
+
+
+// Sends key trace frames to a Coordinator with its update loop running,
+// pausing between frames like real key input.
+void TrainingWorkload::replayLive
+(Coordinator& coordinator, const size_t frameCount)
+{
+    KeyListener::InputHandler& inputHandler = coordinator;
+    struct timespec frameDelay;
+    frameDelay.tv_sec = 0;
+    frameDelay.tv_nsec = liveFrameNanoseconds;
+    size_t eventIndex = 0;
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        const size_t traceFrame = frame % frameSizes.size();
+        if (traceFrame == 0)
+        {
+            eventIndex = 0;
+        }
+        inputHandler.handleKeyEvents(&traceEvents[eventIndex],
+                frameSizes[traceFrame]);
+        eventIndex += frameSizes[traceFrame];
+        nanosleep(&frameDelay, nullptr);
+    }
+}
+
+
+// Repeatedly sends the whole key trace to a Coordinator without pausing,
+// reading the cursor position after every frame.
+double TrainingWorkload::measureKeyHandling
+(Coordinator& coordinator, CursorTracker& tracker)
+{
+    KeyListener::InputHandler& inputHandler = coordinator;
+    size_t positionSum = 0;
+    using namespace std::chrono;
+    const steady_clock::time_point startTime = steady_clock::now();
+    for (size_t replay = 0; replay < keyReplayCount; replay++)
+    {
+        size_t eventIndex = 0;
+        for (const size_t frameSize : frameSizes)
+        {
+            inputHandler.handleKeyEvents(&traceEvents[eventIndex], frameSize);
+            eventIndex += frameSize;
+            const CursorTracker::Point position = tracker.getCursorPos();
+            positionSum += position.x + position.y;
+        }
+    }
+    const nanoseconds elapsed = duration_cast<nanoseconds>(
+            steady_clock::now() - startTime);
+    // Keep the position reads from being optimized away:
+    volatile size_t positionResult = positionSum;
+    (void) positionResult;
+    return static_cast<double>(elapsed.count())
+            / (keyReplayCount * frameSizes.size());
+}
@@ -0,0 +1,104 @@
+/**
+ * @file  TrainingWorkload.h
+ *
+ * @brief  Replays a fixed input session through CPICursor's input, update,
+ *         and drawing code, and measures how long the hot paths take.
+ *
+ *  The training workload is run with CPICursor --train, and the benchmark
+ * workload with CPICursor --benchmark. Key events come from a generated key
+ * trace that is the same on every run, so no input devices are needed, and
+ * the cursor is drawn through the same frame buffer backend used in normal
+ * operation. make release-pgo keeps the display unchanged by drawing into a
+ * file presented as a frame buffer by libMemoryFrameBuffer.so, or into a vfb
+ * frame buffer selected with PGO_FB_PATH. The training workload collects
+ * profiles for profile-guided optimization builds. The benchmark
+ * workload uses a different key trace and cursor path to compare hot path
+ * timings between builds, so optimized builds aren't measured on the exact
+ * input they were trained on. CPICursor --alloc-check replays the training
+ * key trace into an offscreen buffer to check that no heap memory is
+ * allocated once the input, update, and drawing code has warmed up.
+ */
+
+#pragma once
+#include "KeyListener.h"
+#include <cstddef>
+#include <vector>
+
+class Coordinator;
+class CursorTracker;
+
+class TrainingWorkload
+{
+public:
+    /**
+     * @brief  Lists the workloads that can be replayed.
+     */
+    enum class Trace
+    {
+        // Collects optimization profiles:
+        training,
+        // Compares build performance:
+        benchmark
+    };
+
+    /**
+     * @brief  Generates the key trace on construction.
+     *
+     * @param trace  The workload to replay.
+     */
+    TrainingWorkload(const Trace trace = Trace::training);
+
+    /**
+     * @brief  Runs all workload stages, printing each measured time to
+     *         standard output as a "train.<name> <nanoseconds>" line, or as a
+     *         "bench.<name> <nanoseconds>" line for the benchmark workload.
+     *
+     * @param frameBufferPath  The path to the frame buffer device drawn to.
+     *
+     * @return                 The program exit code.
+     */
+    int run(const char* frameBufferPath);
+
+    /**
+     * @brief  Replays the key trace through the full input to drawing
+     *         pipeline, checking that no heap memory is allocated after the
+     *         first frames warm it up. This requires an ALLOC_CHECK=1 build.
+     *
+     * @return  Zero if nothing was allocated, or one if memory was allocated
+     *          or allocations can't be counted in this build.
+     */
+    int checkAllocations();
+
+private:
+    /**
+     * @brief  Sends key trace frames to a Coordinator with its update loop
+     *         running and drawing through a painter thread, pausing between
+     *         frames like real key input.
+     *
+     * @param coordinator  The coordinator receiving key events.
+     *
+     * @param frameCount   The number of key trace frames to send.
+     */
+    void replayLive(Coordinator& coordinator, const size_t frameCount);
+
+    /**
+     * @brief  Repeatedly sends the whole key trace to a Coordinator without
+     *         pausing, reading the cursor position after every frame.
+     *
+     * @param coordinator  A coordinator with no update loop running.
+     *
+     * @param tracker      The coordinator's cursor tracker.
+     *
+     * @return             The average time spent handling each key trace
+     *                     frame, in nanoseconds.
+     */
+    double measureKeyHandling(Coordinator& coordinator,
+            CursorTracker& tracker);
+
+    // The workload being replayed:
+    const Trace trace;
+    // All key events in the trace, in order:
+    std::vector<KeyListener::KeyEvent> traceEvents;
+    // The number of simultaneous key events in each trace frame:
+    std::vector<size_t> frameSizes;
+};
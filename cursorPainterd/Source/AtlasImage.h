@@ -0,0 +1,147 @@
+/**
+ * @file  AtlasImage.h
+ *
+ * @brief  Adapts cursor atlas images so that they can be drawn with FBPainter.
+ *
+ *  Each AtlasImage class provides the same static interface as the image
+ * classes generated by FBPainter's ImageEncoder, so any atlas shape may be
+ * loaded as an FBPainter::CodeImage. FBPainter images need a fixed size, so
+ * there is a separate AtlasImage class for every rotation and scale of every
+ * shape, numbered by variant index. Only the variants that are used are ever
+ * loaded.
+ */
+
+#pragma once
+#include "CursorAtlas.h"
+#include "DisplayTransform.h"
+#include "CodeImage.h"
+#include <cstddef>
+#include <limits>
+
+namespace AtlasVariant
+{
+    // Number of image variants created for each cursor shape:
+    static const constexpr size_t variantsPerShape
+            = DisplayTransform::rotationCount * DisplayTransform::maxScale;
+
+    // Total number of image variants:
+    static const constexpr size_t variantCount
+            = CursorAtlas::shapeCount * variantsPerShape;
+
+    /**
+     * @brief  Gets the variant index of a cursor shape drawn with a display
+     *         transform.
+     *
+     * @param shapeIndex  The index of a CursorAtlas::Shape.
+     *
+     * @param transform   The transform applied to the cursor image.
+     *
+     * @return            The index of the AtlasImage class that holds the
+     *                    transformed shape.
+     */
+    inline size_t getIndex(const size_t shapeIndex,
+            const DisplayTransform& transform)
+    {
+        return shapeIndex * variantsPerShape
+                + static_cast<size_t>(transform.getRotation())
+                    * DisplayTransform::maxScale
+                + transform.getScale() - 1;
+    }
+}
+
+template <size_t variantIndex>
+class AtlasImage
+{
+private:
+    // The cursor shape, rotation, and scale held by this variant:
+    static const constexpr size_t shapeIndex
+            = variantIndex / AtlasVariant::variantsPerShape;
+    static const constexpr DisplayTransform::Rotation rotation
+            = static_cast<DisplayTransform::Rotation>((variantIndex
+                / DisplayTransform::maxScale)
+                % DisplayTransform::rotationCount);
+    static const constexpr size_t scale
+            = variantIndex % DisplayTransform::maxScale + 1;
+    // Whether rotation swaps the image width and height:
+    static const constexpr bool swapsAxes
+            = (static_cast<size_t>(rotation) % 2) == 1;
+    // Unmodified image size:
+    static const constexpr size_t sourceWidth
+            = CursorAtlas::widths[shapeIndex];
+    static const constexpr size_t sourceHeight
+            = CursorAtlas::heights[shapeIndex];
+
+public:
+    // Represents an invalid index:
+    static const constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    // Number of distinct image colors:
+    static const constexpr size_t numColors
+            = CursorAtlas::colorCounts[shapeIndex];
+
+    // Image width in pixels:
+    static const constexpr size_t width
+            = (swapsAxes ? sourceHeight : sourceWidth) * scale;
+
+    // Image height in pixels:
+    static const constexpr size_t height
+            = (swapsAxes ? sourceWidth : sourceHeight) * scale;
+
+    /**
+     * @brief  Gets the color of an image pixel.
+     *
+     * @param x  The pixel's x-coordinate.
+     *
+     * @param y  The pixel's y-coordinate.
+     *
+     * @return   The color of that pixel, or a null RGBAPixel if the
+     *           coordinates are invalid.
+     */
+    static FBPainter::RGBAPixel getColor(const size_t x, const size_t y)
+    {
+        if (x >= width || y >= height)
+        {
+            return FBPainter::RGBAPixel();
+        }
+        size_t sourceX, sourceY;
+        DisplayTransform::getSourcePixel(rotation, scale, sourceWidth,
+                sourceHeight, x, y, sourceX, sourceY);
+        const uint32_t pixel = CursorAtlas::sprites[shapeIndex]
+                .pixels[sourceY * sourceWidth + sourceX];
+        return FBPainter::RGBAPixel((pixel >> 16) & 0xff, (pixel >> 8) & 0xff,
+                pixel & 0xff, pixel >> 24);
+    }
+
+    /**
+     * @brief  Creates an FBPainter image for a cursor image variant. Each
+     *         AtlasImage handles its own variant index, and passes all other
+     *         indices on to the next AtlasImage class.
+     *
+     * @param index  A variant index returned by AtlasVariant::getIndex.
+     *
+     * @return       A new image holding that variant, or nullptr if the index
+     *               is invalid.
+     */
+    static FBPainter::Image* createImage(const size_t index)
+    {
+        if (index == variantIndex)
+        {
+            return new FBPainter::CodeImage<AtlasImage<variantIndex>>;
+        }
+        return AtlasImage<variantIndex + 1>::createImage(index);
+    }
+};
+
+/**
+ * @brief  Ends the chain of AtlasImage::createImage calls after the last
+ *         variant.
+ */
+template <>
+class AtlasImage<AtlasVariant::variantCount>
+{
+public:
+    static FBPainter::Image* createImage(const size_t index)
+    {
+        return nullptr;
+    }
+};
@@ -0,0 +1,91 @@
+#include "CursorBackend.h"
+#include "FrameBufferPainter.h"
+#include "OffscreenBuffer.h"
+#include "MultiDisplay.h"
+#if DRM_BACKEND
+#include "DRMCursor.h"
+#endif
+#if X11_BACKEND
+#include "X11Cursor.h"
+#endif
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Creates a cursor backend, falling back to the frame buffer backend if the
+// requested backend can't be used.
+std::unique_ptr<CursorBackend> CursorBackend::create(const Type type,
+        const RealTime::ThreadConfig workerConfig, const char* displayName)
+{
+    if (type == Type::offscreen)
+    {
+        return std::unique_ptr<CursorBackend>(new OffscreenBuffer);
+    }
+    if (type == Type::drm)
+    {
+#if DRM_BACKEND
+        std::unique_ptr<DRMCursor> drmCursor(new DRMCursor(DRM_PATH));
+        if (drmCursor->isReady())
+        {
+            return std::move(drmCursor);
+        }
+        fprintf(stderr, "CursorBackend: DRM cursor unavailable, drawing to "
+                "the frame buffer instead.\n");
+#else
+        fprintf(stderr, "CursorBackend: Built without DRM_BACKEND, drawing "
+                "to the frame buffer instead.\n");
+#endif
+    }
+    if (type == Type::x11)
+    {
+#if X11_BACKEND
+        std::unique_ptr<X11Cursor> x11Cursor(new X11Cursor(displayName));
+        if (x11Cursor->isReady())
+        {
+            return std::move(x11Cursor);
+        }
+        fprintf(stderr, "CursorBackend: X11 overlay unavailable, drawing to "
+                "the frame buffer instead.\n");
+#else
+        (void) displayName;
+        fprintf(stderr, "CursorBackend: Built without X11_BACKEND, drawing "
+                "to the frame buffer instead.\n");
+#endif
+    }
+    std::unique_ptr<CursorBackend> frameBuffer(new FrameBufferPainter(FB_PATH));
+    const std::string extraPaths(EXTRA_FB_PATHS);
+    if (extraPaths.empty())
+    {
+        return frameBuffer;
+    }
+    // Extra frame buffer paths are separated by colons:
+    std::vector<std::unique_ptr<CursorBackend>> displays;
+    displays.push_back(std::move(frameBuffer));
+    size_t pathStart = 0;
+    while (pathStart < extraPaths.size())
+    {
+        size_t pathEnd = extraPaths.find(':', pathStart);
+        if (pathEnd == std::string::npos)
+        {
+            pathEnd = extraPaths.size();
+        }
+        const std::string path
+                = extraPaths.substr(pathStart, pathEnd - pathStart);
+        pathStart = pathEnd + 1;
+        if (path.empty())
+        {
+            continue;
+        }
+        if (access(path.c_str(), R_OK | W_OK) != 0)
+        {
+            fprintf(stderr, "CursorBackend: Skipping inaccessible frame "
+                    "buffer \"%s\".\n", path.c_str());
+            continue;
+        }
+        displays.emplace_back(new FrameBufferPainter(path.c_str()));
+    }
+    return std::unique_ptr<CursorBackend>(new MultiDisplay(
+            std::move(displays), MultiDisplay::parseLayout(DISPLAY_LAYOUT),
+            workerConfig));
+}
@@ -0,0 +1,112 @@
+/**
+ * @file  CursorBackend.h
+ *
+ * @brief  An abstract interface for the different ways of putting the cursor
+ *         on the display.
+ */
+
+#pragma once
+#include "CursorAtlas.h"
+#include "RealTime.h"
+#include "Stats.h"
+#include <cstddef>
+#include <memory>
+
+class CursorBackend
+{
+public:
+    /**
+     * @brief  Lists all available cursor backends.
+     */
+    enum class Type
+    {
+        // Draws the cursor into the frame buffer:
+        frameBuffer,
+        // Moves a hardware cursor plane using DRM/KMS:
+        drm,
+        // Draws the cursor into a buffer in memory, without using any
+        // display devices:
+        offscreen,
+        // Moves a shaped overlay window within an X11 session:
+        x11
+    };
+
+    CursorBackend() { }
+
+    virtual ~CursorBackend() { }
+
+    /**
+     * @brief  Creates a cursor backend. If the requested backend can't be
+     *         used, the frame buffer backend is created instead. If extra
+     *         frame buffers are listed in EXTRA_FB_PATHS, the frame buffer
+     *         backend draws to all of them, using one worker thread for each
+     *         frame buffer.
+     *
+     * @param type          The type of backend to create.
+     *
+     * @param workerConfig  Scheduling options to apply to any worker threads
+     *                      the backend uses.
+     *
+     * @param displayName   The X display used by the X11 backend, or nullptr
+     *                      to use the DISPLAY environment variable.
+     *
+     * @return              The new cursor backend.
+     */
+    static std::unique_ptr<CursorBackend> create(const Type type,
+            const RealTime::ThreadConfig workerConfig
+            = RealTime::ThreadConfig(), const char* displayName = nullptr);
+
+    /**
+     * @brief  Gets the display width in pixels.
+     *
+     * @return  The display width.
+     */
+    virtual size_t getWidth() const = 0;
+
+    /**
+     * @brief  Gets the display height in pixels.
+     *
+     * @return  The display height.
+     */
+    virtual size_t getHeight() const = 0;
+
+    /**
+     * @brief  Shows the cursor with its hotspot at a display coordinate,
+     *         removing it from its last position if it moved.
+     *
+     * @param x  Screen x-coordinate, measured in pixels.
+     *
+     * @param y  Screen y-coordinate, measured in pixels.
+     */
+    virtual void drawCursor(const size_t x, const size_t y) = 0;
+
+    /**
+     * @brief  Switches the image used to show the cursor, updating the
+     *         cursor immediately if it is already shown. All shape images
+     *         are prepared when the backend is created, so switching shapes
+     *         never loads or converts image data.
+     *
+     * @param shape  The new cursor shape.
+     */
+    virtual void setShape(const CursorAtlas::Shape shape) = 0;
+
+    /**
+     * @brief  Removes the cursor from the display until the next time
+     *         drawCursor is called.
+     */
+    virtual void hideCursor() = 0;
+
+    /**
+     * @brief  Waits until all cursor updates sent so far are visible, for
+     *         backends that update the display asynchronously.
+     */
+    virtual void waitForDisplay() { }
+
+    /**
+     * @brief  Adds the backend's performance counters to a stats file, if it
+     *         has any.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    virtual void registerStats(Stats::StatsFile& /*statsFile*/) const { }
+};
@@ -0,0 +1,506 @@
+#include "DRMCursor.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+// Kernel DRM interface headers, found through libdrm's include directory:
+#include <drm.h>
+#include <drm_mode.h>
+
+// Prints an error message for a failed DRM operation:
+static void printError(const char* action)
+{
+    fprintf(stderr, "DRMCursor: Failed to %s: %s\n", action, strerror(errno));
+}
+
+
+// Runs a DRM ioctl, retrying if it is interrupted.
+static int drmIoctl(const int deviceFD, const unsigned long request, void* arg)
+{
+    int result;
+    do
+    {
+        result = ioctl(deviceFD, request, arg);
+    }
+    while (result == -1 && (errno == EINTR || errno == EAGAIN));
+    return result;
+}
+
+
+// Opens the DRM device, finds an active display, and uploads the cursor images
+// for its cursor plane, rotated and scaled to match the display.
+DRMCursor::DRMCursor(const char* devicePath)
+{
+    deviceFD = open(devicePath, O_RDWR | O_CLOEXEC);
+    if (deviceFD < 0)
+    {
+        printError("open DRM device");
+        return;
+    }
+    // Cursor and mode ioctls need DRM master access. This fails if another
+    // process is already master, in which case the cursor ioctl will fail
+    // below.
+    drmIoctl(deviceFD, DRM_IOCTL_SET_MASTER, nullptr);
+
+    struct drm_get_cap cap;
+    memset(&cap, 0, sizeof(cap));
+    cap.capability = DRM_CAP_CURSOR_WIDTH;
+    if (drmIoctl(deviceFD, DRM_IOCTL_GET_CAP, &cap) == 0 && cap.value > 0)
+    {
+        cursorWidth = cap.value;
+    }
+    cap.capability = DRM_CAP_CURSOR_HEIGHT;
+    if (drmIoctl(deviceFD, DRM_IOCTL_GET_CAP, &cap) == 0 && cap.value > 0)
+    {
+        cursorHeight = cap.value;
+    }
+    if (! findActiveCrtc())
+    {
+        return;
+    }
+    // The display's physical size is unknown here, so cursor scale is chosen
+    // from the display resolution:
+    transform = DisplayTransform::detect(width, height);
+    if (! transform.limitScale(cursorWidth, cursorHeight))
+    {
+        fprintf(stderr, "DRMCursor: Cursor plane is too small.\n");
+        return;
+    }
+    for (size_t i = 0; i < CursorAtlas::shapeCount; i++)
+    {
+        shapeBounds[i] = transform.getVariantBounds(CursorAtlas::sprites[i]);
+    }
+    ready = uploadCursors() && showShape(0);
+}
+
+
+// Hides the cursor and releases all DRM resources on destruction.
+DRMCursor::~DRMCursor()
+{
+    if (deviceFD < 0)
+    {
+        return;
+    }
+    if (cursorHandles[0] != 0)
+    {
+        struct drm_mode_cursor cursor;
+        memset(&cursor, 0, sizeof(cursor));
+        cursor.flags = DRM_MODE_CURSOR_BO;
+        cursor.crtc_id = crtcID;
+        drmIoctl(deviceFD, DRM_IOCTL_MODE_CURSOR, &cursor);
+    }
+    for (const uint32_t cursorHandle : cursorHandles)
+    {
+        if (cursorHandle != 0)
+        {
+            struct drm_mode_destroy_dumb destroy;
+            memset(&destroy, 0, sizeof(destroy));
+            destroy.handle = cursorHandle;
+            drmIoctl(deviceFD, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+        }
+    }
+    if (modeFrameBufferID != 0)
+    {
+        drmIoctl(deviceFD, DRM_IOCTL_MODE_RMFB, &modeFrameBufferID);
+    }
+    if (modeBufferHandle != 0)
+    {
+        struct drm_mode_destroy_dumb destroy;
+        memset(&destroy, 0, sizeof(destroy));
+        destroy.handle = modeBufferHandle;
+        drmIoctl(deviceFD, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+    }
+    drmIoctl(deviceFD, DRM_IOCTL_DROP_MASTER, nullptr);
+    close(deviceFD);
+}
+
+
+// Checks if the DRM cursor was successfully set up.
+bool DRMCursor::isReady() const
+{
+    return ready;
+}
+
+
+// Gets the display width in pixels, after rotation.
+size_t DRMCursor::getWidth() const
+{
+    return transform.getWidth();
+}
+
+
+// Gets the display height in pixels, after rotation.
+size_t DRMCursor::getHeight() const
+{
+    return transform.getHeight();
+}
+
+
+// Moves the hardware cursor to a display coordinate.
+void DRMCursor::drawCursor(const size_t x, const size_t y)
+{
+    if (! ready)
+    {
+        return;
+    }
+    size_t physicalX, physicalY;
+    transform.toPhysical(x, y, physicalX, physicalY);
+    if (lastX == (int32_t) physicalX && lastY == (int32_t) physicalY)
+    {
+        return;
+    }
+    if (hidden)
+    {
+        // Enable the cursor buffer and move it with a single ioctl.
+        // showShape reads the new position from lastX and lastY:
+        lastX = physicalX;
+        lastY = physicalY;
+        hidden = ! showShape(activeSprite - shapeBounds);
+        if (hidden)
+        {
+            // Forget the position so that drawing it again retries:
+            lastX = -1;
+            lastY = -1;
+        }
+        return;
+    }
+    struct drm_mode_cursor cursor;
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.flags = DRM_MODE_CURSOR_MOVE;
+    cursor.crtc_id = crtcID;
+    // The cursor plane may extend past the display edges, so the hotspot can
+    // always reach every display pixel:
+    cursor.x = (int32_t) physicalX - (int32_t) activeSprite->hotspotX;
+    cursor.y = (int32_t) physicalY - (int32_t) activeSprite->hotspotY;
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_CURSOR, &cursor) == 0)
+    {
+        lastX = physicalX;
+        lastY = physicalY;
+    }
+}
+
+
+// Switches the hardware cursor to the buffer holding a different cursor shape.
+void DRMCursor::setShape(const CursorAtlas::Shape shape)
+{
+    const size_t shapeIndex = static_cast<size_t>(shape);
+    if (! ready || shapeIndex >= CursorAtlas::shapeCount
+            || activeSprite == &shapeBounds[shapeIndex])
+    {
+        return;
+    }
+    if (hidden)
+    {
+        // Select the new shape without showing it:
+        activeSprite = &shapeBounds[shapeIndex];
+        return;
+    }
+    showShape(shapeIndex);
+}
+
+
+// Disables the hardware cursor until it is drawn again.
+void DRMCursor::hideCursor()
+{
+    if (! ready || hidden)
+    {
+        return;
+    }
+    struct drm_mode_cursor cursor;
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.flags = DRM_MODE_CURSOR_BO;
+    cursor.crtc_id = crtcID;
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_CURSOR, &cursor) == 0)
+    {
+        hidden = true;
+        lastX = -1;
+        lastY = -1;
+    }
+}
+
+
+// Finds a CRTC with an active display mode, setting a mode if none are active.
+bool DRMCursor::findActiveCrtc()
+{
+    struct drm_mode_card_res resources;
+    memset(&resources, 0, sizeof(resources));
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETRESOURCES, &resources) != 0)
+    {
+        printError("read DRM resources");
+        return false;
+    }
+    std::vector<uint32_t> crtcIDs(resources.count_crtcs);
+    memset(&resources, 0, sizeof(resources));
+    resources.count_crtcs = crtcIDs.size();
+    resources.crtc_id_ptr = reinterpret_cast<uint64_t>(crtcIDs.data());
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETRESOURCES, &resources) != 0)
+    {
+        printError("read DRM CRTCs");
+        return false;
+    }
+    for (const uint32_t id : crtcIDs)
+    {
+        struct drm_mode_crtc crtc;
+        memset(&crtc, 0, sizeof(crtc));
+        crtc.crtc_id = id;
+        if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETCRTC, &crtc) == 0
+                && crtc.mode_valid && crtc.fb_id != 0)
+        {
+            crtcID = id;
+            width = crtc.mode.hdisplay;
+            height = crtc.mode.vdisplay;
+            return true;
+        }
+    }
+    return setInitialMode();
+}
+
+
+// Sets the first mode of the first connected connector on a CRTC that can
+// drive it, using a blank frame buffer.
+bool DRMCursor::setInitialMode()
+{
+    struct drm_mode_card_res resources;
+    memset(&resources, 0, sizeof(resources));
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETRESOURCES, &resources) != 0)
+    {
+        printError("read DRM resources");
+        return false;
+    }
+    std::vector<uint32_t> crtcIDs(resources.count_crtcs);
+    std::vector<uint32_t> connectorIDs(resources.count_connectors);
+    memset(&resources, 0, sizeof(resources));
+    resources.count_crtcs = crtcIDs.size();
+    resources.crtc_id_ptr = reinterpret_cast<uint64_t>(crtcIDs.data());
+    resources.count_connectors = connectorIDs.size();
+    resources.connector_id_ptr
+            = reinterpret_cast<uint64_t>(connectorIDs.data());
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETRESOURCES, &resources) != 0)
+    {
+        printError("read DRM connectors");
+        return false;
+    }
+
+    for (uint32_t connectorID : connectorIDs)
+    {
+        struct drm_mode_get_connector connector;
+        memset(&connector, 0, sizeof(connector));
+        connector.connector_id = connectorID;
+        if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETCONNECTOR, &connector) != 0
+                || connector.connection != DRM_MODE_CONNECTED
+                || connector.count_modes == 0
+                || connector.count_encoders == 0)
+        {
+            continue;
+        }
+        std::vector<struct drm_mode_modeinfo> modes(connector.count_modes);
+        std::vector<uint32_t> encoderIDs(connector.count_encoders);
+        connector.modes_ptr = reinterpret_cast<uint64_t>(modes.data());
+        connector.encoders_ptr = reinterpret_cast<uint64_t>(encoderIDs.data());
+        connector.count_props = 0;
+        connector.props_ptr = 0;
+        connector.prop_values_ptr = 0;
+        if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETCONNECTOR, &connector) != 0)
+        {
+            continue;
+        }
+
+        // Find a CRTC that can drive this connector:
+        uint32_t modeCrtcID = 0;
+        for (const uint32_t encoderID : encoderIDs)
+        {
+            struct drm_mode_get_encoder encoder;
+            memset(&encoder, 0, sizeof(encoder));
+            encoder.encoder_id = encoderID;
+            if (drmIoctl(deviceFD, DRM_IOCTL_MODE_GETENCODER, &encoder) != 0)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < crtcIDs.size() && modeCrtcID == 0; i++)
+            {
+                if (encoder.possible_crtcs & (1 << i))
+                {
+                    modeCrtcID = crtcIDs[i];
+                }
+            }
+            if (modeCrtcID != 0)
+            {
+                break;
+            }
+        }
+        if (modeCrtcID == 0)
+        {
+            continue;
+        }
+
+        // Create a blank frame buffer to scan out:
+        struct drm_mode_modeinfo& mode = modes[0];
+        uint32_t pitch;
+        uint64_t size;
+        void* pixels = createDumbBuffer(mode.hdisplay, mode.vdisplay,
+                modeBufferHandle, pitch, size);
+        if (pixels == nullptr)
+        {
+            return false;
+        }
+        memset(pixels, 0, size);
+        munmap(pixels, size);
+        struct drm_mode_fb_cmd frameBuffer;
+        memset(&frameBuffer, 0, sizeof(frameBuffer));
+        frameBuffer.width = mode.hdisplay;
+        frameBuffer.height = mode.vdisplay;
+        frameBuffer.pitch = pitch;
+        frameBuffer.bpp = 32;
+        frameBuffer.depth = 24;
+        frameBuffer.handle = modeBufferHandle;
+        if (drmIoctl(deviceFD, DRM_IOCTL_MODE_ADDFB, &frameBuffer) != 0)
+        {
+            printError("add DRM frame buffer");
+            return false;
+        }
+        modeFrameBufferID = frameBuffer.fb_id;
+
+        struct drm_mode_crtc crtc;
+        memset(&crtc, 0, sizeof(crtc));
+        crtc.crtc_id = modeCrtcID;
+        crtc.fb_id = modeFrameBufferID;
+        crtc.set_connectors_ptr = reinterpret_cast<uint64_t>(&connectorID);
+        crtc.count_connectors = 1;
+        crtc.mode = mode;
+        crtc.mode_valid = 1;
+        if (drmIoctl(deviceFD, DRM_IOCTL_MODE_SETCRTC, &crtc) != 0)
+        {
+            printError("set DRM display mode");
+            return false;
+        }
+        crtcID = modeCrtcID;
+        width = mode.hdisplay;
+        height = mode.vdisplay;
+        return true;
+    }
+    fprintf(stderr, "DRMCursor: No connected display found.\n");
+    return false;
+}
+
+
+// Creates a 32-bit dumb buffer and maps it into memory.
+void* DRMCursor::createDumbBuffer(const uint32_t width, const uint32_t height,
+        uint32_t& handle, uint32_t& pitch, uint64_t& size)
+{
+    struct drm_mode_create_dumb create;
+    memset(&create, 0, sizeof(create));
+    create.width = width;
+    create.height = height;
+    create.bpp = 32;
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_CREATE_DUMB, &create) != 0)
+    {
+        printError("create DRM buffer");
+        return nullptr;
+    }
+    handle = create.handle;
+    pitch = create.pitch;
+    size = create.size;
+    struct drm_mode_map_dumb map;
+    memset(&map, 0, sizeof(map));
+    map.handle = handle;
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_MAP_DUMB, &map) != 0)
+    {
+        printError("prepare DRM buffer mapping");
+        return nullptr;
+    }
+    void* pixels = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            deviceFD, map.offset);
+    if (pixels == MAP_FAILED)
+    {
+        printError("map DRM buffer");
+        return nullptr;
+    }
+    return pixels;
+}
+
+
+// Copies each cursor shape's transformed image into its own cursor buffer, with
+// color components premultiplied by alpha.
+bool DRMCursor::uploadCursors()
+{
+    for (size_t i = 0; i < CursorAtlas::shapeCount; i++)
+    {
+        uint32_t pitch;
+        uint64_t size;
+        void* buffer = createDumbBuffer(cursorWidth, cursorHeight,
+                cursorHandles[i], pitch, size);
+        if (buffer == nullptr)
+        {
+            return false;
+        }
+        memset(buffer, 0, size);
+        const CursorAtlas::Sprite& bounds = shapeBounds[i];
+        uint32_t* pixels = static_cast<uint32_t*>(buffer);
+        const size_t rowLength = pitch / 4;
+        transform.copyVariantPixels(CursorAtlas::sprites[i], pixels,
+                rowLength);
+        for (size_t y = 0; y < bounds.height; y++)
+        {
+            for (size_t x = 0; x < bounds.width; x++)
+            {
+                const uint32_t color = pixels[y * rowLength + x];
+                const uint32_t alpha = color >> 24;
+                pixels[y * rowLength + x] = (alpha << 24)
+                        | ((((color >> 16) & 0xff) * alpha / 255) << 16)
+                        | ((((color >> 8) & 0xff) * alpha / 255) << 8)
+                        | ((color & 0xff) * alpha / 255);
+            }
+        }
+        munmap(buffer, size);
+    }
+    return true;
+}
+
+
+// Shows a cursor buffer on the CRTC's cursor plane, with its hotspot at the
+// last cursor position.
+bool DRMCursor::showShape(const size_t shapeIndex)
+{
+    const CursorAtlas::Sprite& sprite = shapeBounds[shapeIndex];
+    // Set the new buffer and its position with a single ioctl, so the old
+    // shape is never shown at the new shape's position:
+    const uint32_t flags = DRM_MODE_CURSOR_BO
+            | ((lastX >= 0) ? DRM_MODE_CURSOR_MOVE : 0);
+    const int32_t x = lastX - (int32_t) sprite.hotspotX;
+    const int32_t y = lastY - (int32_t) sprite.hotspotY;
+    struct drm_mode_cursor2 cursor;
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.flags = flags;
+    cursor.crtc_id = crtcID;
+    cursor.x = x;
+    cursor.y = y;
+    cursor.width = cursorWidth;
+    cursor.height = cursorHeight;
+    cursor.handle = cursorHandles[shapeIndex];
+    cursor.hot_x = sprite.hotspotX;
+    cursor.hot_y = sprite.hotspotY;
+    if (drmIoctl(deviceFD, DRM_IOCTL_MODE_CURSOR2, &cursor) != 0)
+    {
+        // Older drivers only support the original cursor ioctl:
+        struct drm_mode_cursor oldCursor;
+        memset(&oldCursor, 0, sizeof(oldCursor));
+        oldCursor.flags = flags;
+        oldCursor.crtc_id = crtcID;
+        oldCursor.x = x;
+        oldCursor.y = y;
+        oldCursor.width = cursorWidth;
+        oldCursor.height = cursorHeight;
+        oldCursor.handle = cursorHandles[shapeIndex];
+        if (drmIoctl(deviceFD, DRM_IOCTL_MODE_CURSOR, &oldCursor) != 0)
+        {
+            printError("set DRM cursor image");
+            return false;
+        }
+    }
+    activeSprite = &sprite;
+    return true;
+}
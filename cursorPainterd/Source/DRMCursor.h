@@ -0,0 +1,166 @@
+/**
+ * @file  DRMCursor.h
+ *
+ * @brief  A cursor backend that shows the cursor on a DRM/KMS hardware cursor
+ *         plane.
+ *
+ *  Every cursor shape is rotated and scaled to match the display, and copied
+ * into its own cursor buffer once on construction. After that, each cursor
+ * move or shape change is a single cursor ioctl, and no pixels are written.
+ * If no CRTC is active, DRMCursor sets the first mode of the first connected
+ * connector with a blank frame buffer, so the backend can also be used on a
+ * virtual KMS device such as vkms.
+ *
+ *  Cursor ioctls require DRM master access, so this backend is unavailable
+ * while another process such as an X server controls the display.
+ */
+
+#pragma once
+#include "CursorBackend.h"
+#include "CursorAtlas.h"
+#include "DisplayTransform.h"
+#include <cstdint>
+
+class DRMCursor : public CursorBackend
+{
+public:
+    /**
+     * @brief  Opens the DRM device, finds an active display, and uploads the
+     *         cursor images for its cursor plane.
+     *
+     * @param devicePath  The path to the DRM card device file.
+     */
+    DRMCursor(const char* devicePath);
+
+    /**
+     * @brief  Hides the cursor and releases all DRM resources on
+     *         destruction.
+     */
+    virtual ~DRMCursor();
+
+    /**
+     * @brief  Checks if the DRM cursor was successfully set up.
+     *
+     * @return  Whether the cursor can be shown with this backend.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief  Gets the display width in pixels, after rotation.
+     *
+     * @return  The width of the active display mode.
+     */
+    virtual size_t getWidth() const override;
+
+    /**
+     * @brief  Gets the display height in pixels, after rotation.
+     *
+     * @return  The height of the active display mode.
+     */
+    virtual size_t getHeight() const override;
+
+    /**
+     * @brief  Moves the hardware cursor to a display coordinate.
+     *
+     * @param x  Screen x-coordinate, measured in pixels.
+     *
+     * @param y  Screen y-coordinate, measured in pixels.
+     */
+    virtual void drawCursor(const size_t x, const size_t y) override;
+
+    /**
+     * @brief  Switches the hardware cursor to the buffer holding a different
+     *         cursor shape.
+     *
+     * @param shape  The new cursor shape.
+     */
+    virtual void setShape(const CursorAtlas::Shape shape) override;
+
+    /**
+     * @brief  Disables the hardware cursor until it is drawn again.
+     */
+    virtual void hideCursor() override;
+
+private:
+    /**
+     * @brief  Finds a CRTC with an active display mode, setting a mode if
+     *         none are active.
+     *
+     * @return  Whether an active CRTC was found or created.
+     */
+    bool findActiveCrtc();
+
+    /**
+     * @brief  Sets the first mode of the first connected connector on a CRTC
+     *         that can drive it, using a blank frame buffer.
+     *
+     * @return  Whether a mode was set.
+     */
+    bool setInitialMode();
+
+    /**
+     * @brief  Creates a 32-bit dumb buffer and maps it into memory.
+     *
+     * @param width   Buffer width in pixels.
+     *
+     * @param height  Buffer height in pixels.
+     *
+     * @param handle  Used to return the new buffer's handle.
+     *
+     * @param pitch   Used to return the length of a buffer row in bytes.
+     *
+     * @param size    Used to return the buffer size in bytes.
+     *
+     * @return        The mapped buffer, or nullptr if creating or mapping the
+     *                buffer failed.
+     */
+    void* createDumbBuffer(const uint32_t width, const uint32_t height,
+            uint32_t& handle, uint32_t& pitch, uint64_t& size);
+
+    /**
+     * @brief  Copies each cursor shape's transformed image into its own
+     *         cursor buffer, with color components premultiplied by alpha.
+     *
+     * @return  Whether all cursor buffers were created.
+     */
+    bool uploadCursors();
+
+    /**
+     * @brief  Shows a cursor buffer on the CRTC's cursor plane, with its
+     *         hotspot at the last cursor position.
+     *
+     * @param shapeIndex  The index of the cursor shape to show.
+     *
+     * @return            Whether the cursor buffer was enabled.
+     */
+    bool showShape(const size_t shapeIndex);
+
+    // Open DRM device file descriptor:
+    int deviceFD = -1;
+    // The CRTC whose cursor plane is used:
+    uint32_t crtcID = 0;
+    // Active display resolution, before rotation:
+    size_t width = 0;
+    size_t height = 0;
+    // Maps display coordinates to CRTC coordinates:
+    DisplayTransform transform;
+    // Transformed size and hotspot of each cursor shape:
+    CursorAtlas::Sprite shapeBounds [CursorAtlas::shapeCount];
+    // Cursor buffer handles, indexed by shape:
+    uint32_t cursorHandles [CursorAtlas::shapeCount] = {0};
+    // Transformed bounds of the shape currently shown:
+    const CursorAtlas::Sprite* activeSprite = &shapeBounds[0];
+    // Cursor buffer dimensions:
+    uint32_t cursorWidth = 64;
+    uint32_t cursorHeight = 64;
+    // Frame buffer and buffer handle created when setting an initial mode:
+    uint32_t modeFrameBufferID = 0;
+    uint32_t modeBufferHandle = 0;
+    // Whether the cursor was set up successfully:
+    bool ready = false;
+    // Whether the cursor was disabled by hideCursor:
+    bool hidden = false;
+    // Last cursor hotspot position on the CRTC, used to skip redundant moves:
+    int32_t lastX = -1;
+    int32_t lastY = -1;
+};
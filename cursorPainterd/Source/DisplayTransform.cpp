@@ -0,0 +1,228 @@
+#include "DisplayTransform.h"
+#include <algorithm>
+#include <fstream>
+
+// File holding the fbcon rotation value:
+static const constexpr char* fbconRotationPath
+        = "/sys/class/graphics/fbcon/rotate";
+
+// Display density in pixels per inch that needs no cursor scaling:
+static const constexpr size_t baseDensity = 96;
+
+// Display height in pixels that needs no cursor scaling, used when the
+// display size is unknown:
+static const constexpr size_t baseResolution = 720;
+
+// Checks if a rotation swaps the width and height of rotated areas.
+static bool swapsAxes(const DisplayTransform::Rotation rotation)
+{
+    return rotation == DisplayTransform::Rotation::clockwise
+            || rotation == DisplayTransform::Rotation::counterClockwise;
+}
+
+
+// Creates a transform for a display with a fixed rotation and cursor scale.
+DisplayTransform::DisplayTransform(const size_t physicalWidth,
+        const size_t physicalHeight, const Rotation rotation,
+        const size_t scale) :
+    physicalWidth(physicalWidth), physicalHeight(physicalHeight),
+    rotation(rotation), scale(scale)
+{
+    if (scale == 0)
+    {
+        this->scale = 1;
+    }
+    else if (scale > maxScale)
+    {
+        this->scale = maxScale;
+    }
+}
+
+
+// Creates a transform for a display, using build options or detecting its
+// rotation and pixel density.
+DisplayTransform DisplayTransform::detect(const size_t physicalWidth,
+        const size_t physicalHeight, const size_t widthMM,
+        const size_t heightMM)
+{
+    int rotationValue = CURSOR_ROTATION;
+    if (rotationValue < 0)
+    {
+        rotationValue = 0;
+        std::ifstream rotationFile(fbconRotationPath);
+        rotationFile >> rotationValue;
+    }
+    const Rotation rotation = (rotationValue >= 0
+            && static_cast<size_t>(rotationValue) < rotationCount)
+            ? static_cast<Rotation>(rotationValue) : Rotation::none;
+
+    size_t scale = CURSOR_SCALE;
+    if (scale == 0)
+    {
+        // Sizes of zero or more than a few meters are placeholders:
+        if (widthMM > 0 && heightMM > 0 && widthMM < 10000
+                && heightMM < 10000)
+        {
+            const size_t density = std::max(physicalWidth * 254 / widthMM,
+                    physicalHeight * 254 / heightMM) / 10;
+            scale = density / baseDensity;
+        }
+        else
+        {
+            scale = std::min(physicalWidth, physicalHeight) / baseResolution;
+        }
+    }
+    return DisplayTransform(physicalWidth, physicalHeight, rotation, scale);
+}
+
+
+// Gets the display rotation.
+DisplayTransform::Rotation DisplayTransform::getRotation() const
+{
+    return rotation;
+}
+
+
+// Gets the cursor image scale.
+size_t DisplayTransform::getScale() const
+{
+    return scale;
+}
+
+
+// Gets the width of the display as the user sees it.
+size_t DisplayTransform::getWidth() const
+{
+    return swapsAxes(rotation) ? physicalHeight : physicalWidth;
+}
+
+
+// Gets the height of the display as the user sees it.
+size_t DisplayTransform::getHeight() const
+{
+    return swapsAxes(rotation) ? physicalWidth : physicalHeight;
+}
+
+
+// Converts a display coordinate into a frame buffer coordinate.
+void DisplayTransform::toPhysical(const size_t x, const size_t y,
+        size_t& physicalX, size_t& physicalY) const
+{
+    const size_t width = getWidth();
+    const size_t height = getHeight();
+    if (width == 0 || height == 0)
+    {
+        physicalX = 0;
+        physicalY = 0;
+        return;
+    }
+    rotatePoint(rotation, width, height, std::min(x, width - 1),
+            std::min(y, height - 1), physicalX, physicalY);
+}
+
+
+// Reduces the cursor image scale until every cursor image fits within a
+// maximum size.
+bool DisplayTransform::limitScale(const size_t maxWidth,
+        const size_t maxHeight)
+{
+    for (; scale > 0; scale--)
+    {
+        bool allFit = true;
+        for (const CursorAtlas::Sprite& sprite : CursorAtlas::sprites)
+        {
+            const CursorAtlas::Sprite bounds = getVariantBounds(sprite);
+            if (bounds.width > maxWidth || bounds.height > maxHeight)
+            {
+                allFit = false;
+                break;
+            }
+        }
+        if (allFit)
+        {
+            return true;
+        }
+    }
+    scale = 1;
+    return false;
+}
+
+
+// Gets the size and hotspot of a cursor image once rotated and scaled.
+CursorAtlas::Sprite DisplayTransform::getVariantBounds
+(const CursorAtlas::Sprite& source) const
+{
+    CursorAtlas::Sprite bounds;
+    const bool swapped = swapsAxes(rotation);
+    bounds.width = (swapped ? source.height : source.width) * scale;
+    bounds.height = (swapped ? source.width : source.height) * scale;
+    size_t hotspotX, hotspotY;
+    rotatePoint(rotation, source.width, source.height, source.hotspotX,
+            source.hotspotY, hotspotX, hotspotY);
+    // Keep the hotspot centered within its scaled pixel:
+    bounds.hotspotX = hotspotX * scale + scale / 2;
+    bounds.hotspotY = hotspotY * scale + scale / 2;
+    bounds.pixels = nullptr;
+    return bounds;
+}
+
+
+// Copies a rotated and scaled cursor image.
+void DisplayTransform::copyVariantPixels(const CursorAtlas::Sprite& source,
+        uint32_t* destination, const size_t rowLength) const
+{
+    const CursorAtlas::Sprite bounds = getVariantBounds(source);
+    for (size_t y = 0; y < bounds.height; y++)
+    {
+        for (size_t x = 0; x < bounds.width; x++)
+        {
+            size_t sourceX, sourceY;
+            getSourcePixel(rotation, scale, source.width, source.height, x, y,
+                    sourceX, sourceY);
+            destination[y * rowLength + x]
+                    = source.pixels[sourceY * source.width + sourceX];
+        }
+    }
+}
+
+
+// Finds the source pixel of a rotated and scaled image pixel.
+void DisplayTransform::getSourcePixel(const Rotation rotation,
+        const size_t scale, const size_t sourceWidth,
+        const size_t sourceHeight, const size_t x, const size_t y,
+        size_t& sourceX, size_t& sourceY)
+{
+    // Undo the rotation by rotating the same amount in the other direction:
+    const Rotation inverse = static_cast<Rotation>(
+            (rotationCount - static_cast<size_t>(rotation)) % rotationCount);
+    const bool swapped = swapsAxes(rotation);
+    rotatePoint(inverse, swapped ? sourceHeight : sourceWidth,
+            swapped ? sourceWidth : sourceHeight, x / scale, y / scale,
+            sourceX, sourceY);
+}
+
+
+// Rotates a point within an area.
+void DisplayTransform::rotatePoint(const Rotation rotation, const size_t width,
+        const size_t height, const size_t x, const size_t y,
+        size_t& rotatedX, size_t& rotatedY)
+{
+    switch (rotation)
+    {
+        case Rotation::clockwise:
+            rotatedX = height - 1 - y;
+            rotatedY = x;
+            return;
+        case Rotation::upsideDown:
+            rotatedX = width - 1 - x;
+            rotatedY = height - 1 - y;
+            return;
+        case Rotation::counterClockwise:
+            rotatedX = y;
+            rotatedY = width - 1 - x;
+            return;
+        default:
+            rotatedX = x;
+            rotatedY = y;
+    }
+}
@@ -0,0 +1,215 @@
+/**
+ * @file  DisplayTransform.h
+ *
+ * @brief  Maps cursor coordinates onto rotated displays, and creates rotated
+ *         and scaled variants of the cursor images.
+ *
+ *  When fbcon rotation is enabled, the console is drawn rotated while the
+ * frame buffer itself is not. CPICursor tracks the cursor within the rotated
+ * display area that the user sees, and DisplayTransform converts each cursor
+ * position into a physical frame buffer pixel. Cursor images are rotated to
+ * match and scaled up on high density displays once when a cursor backend is
+ * created, so drawing the cursor never transforms individual pixels.
+ */
+
+#pragma once
+#include "CursorAtlas.h"
+#include <cstddef>
+#include <cstdint>
+
+class DisplayTransform
+{
+public:
+    /**
+     * @brief  Lists possible display rotations, using the same values as the
+     *         fbcon rotate setting.
+     */
+    enum class Rotation
+    {
+        none = 0,
+        clockwise = 1,
+        upsideDown = 2,
+        counterClockwise = 3
+    };
+
+    // Number of supported rotations:
+    static const constexpr size_t rotationCount = 4;
+
+    // Largest supported cursor image scale:
+    static const constexpr size_t maxScale = 4;
+
+    /**
+     * @brief  Creates a transform for a display with a fixed rotation and
+     *         cursor scale.
+     *
+     * @param physicalWidth   The frame buffer width in pixels.
+     *
+     * @param physicalHeight  The frame buffer height in pixels.
+     *
+     * @param rotation        The display rotation.
+     *
+     * @param scale           The cursor image scale, from 1 to maxScale.
+     */
+    DisplayTransform(const size_t physicalWidth = 0,
+            const size_t physicalHeight = 0,
+            const Rotation rotation = Rotation::none,
+            const size_t scale = 1);
+
+    /**
+     * @brief  Creates a transform for a display, using the CURSOR_ROTATION
+     *         and CURSOR_SCALE build options if set. Otherwise, rotation is
+     *         read from fbcon, and scale is chosen from the display's pixel
+     *         density, or from its resolution if its size is unknown.
+     *
+     * @param physicalWidth   The frame buffer width in pixels.
+     *
+     * @param physicalHeight  The frame buffer height in pixels.
+     *
+     * @param widthMM         The display width in millimeters, or 0 if
+     *                        unknown.
+     *
+     * @param heightMM        The display height in millimeters, or 0 if
+     *                        unknown.
+     *
+     * @return                The detected display transform.
+     */
+    static DisplayTransform detect(const size_t physicalWidth,
+            const size_t physicalHeight, const size_t widthMM = 0,
+            const size_t heightMM = 0);
+
+    /**
+     * @brief  Gets the display rotation.
+     *
+     * @return  The rotation applied to cursor positions and images.
+     */
+    Rotation getRotation() const;
+
+    /**
+     * @brief  Gets the cursor image scale.
+     *
+     * @return  The number of pixels drawn along each axis for each cursor
+     *          image pixel.
+     */
+    size_t getScale() const;
+
+    /**
+     * @brief  Gets the width of the display as the user sees it.
+     *
+     * @return  The rotated display width in pixels.
+     */
+    size_t getWidth() const;
+
+    /**
+     * @brief  Gets the height of the display as the user sees it.
+     *
+     * @return  The rotated display height in pixels.
+     */
+    size_t getHeight() const;
+
+    /**
+     * @brief  Converts a display coordinate into a frame buffer coordinate.
+     *
+     * @param x          The display x-coordinate. Values past the display
+     *                   edge are moved to the edge.
+     *
+     * @param y          The display y-coordinate. Values past the display
+     *                   edge are moved to the edge.
+     *
+     * @param physicalX  Used to return the frame buffer x-coordinate.
+     *
+     * @param physicalY  Used to return the frame buffer y-coordinate.
+     */
+    void toPhysical(const size_t x, const size_t y, size_t& physicalX,
+            size_t& physicalY) const;
+
+    /**
+     * @brief  Reduces the cursor image scale until every cursor image fits
+     *         within a maximum size.
+     *
+     * @param maxWidth   The largest allowed image width in pixels.
+     *
+     * @param maxHeight  The largest allowed image height in pixels.
+     *
+     * @return           Whether all cursor images fit, even if unscaled.
+     */
+    bool limitScale(const size_t maxWidth, const size_t maxHeight);
+
+    /**
+     * @brief  Gets the size and hotspot of a cursor image once rotated and
+     *         scaled.
+     *
+     * @param source  An unmodified cursor atlas image.
+     *
+     * @return        The transformed image size and hotspot. The pixel
+     *                pointer is always null.
+     */
+    CursorAtlas::Sprite getVariantBounds(const CursorAtlas::Sprite& source)
+            const;
+
+    /**
+     * @brief  Copies a rotated and scaled cursor image.
+     *
+     * @param source       An unmodified cursor atlas image.
+     *
+     * @param destination  Where the transformed image's ARGB pixels will be
+     *                     written.
+     *
+     * @param rowLength    The number of pixels between the start of each
+     *                     destination row.
+     */
+    void copyVariantPixels(const CursorAtlas::Sprite& source,
+            uint32_t* destination, const size_t rowLength) const;
+
+    /**
+     * @brief  Finds the source pixel of a rotated and scaled image pixel.
+     *
+     * @param rotation      The image rotation.
+     *
+     * @param scale         The image scale.
+     *
+     * @param sourceWidth   The unmodified image width.
+     *
+     * @param sourceHeight  The unmodified image height.
+     *
+     * @param x             The transformed image x-coordinate.
+     *
+     * @param y             The transformed image y-coordinate.
+     *
+     * @param sourceX       Used to return the source image x-coordinate.
+     *
+     * @param sourceY       Used to return the source image y-coordinate.
+     */
+    static void getSourcePixel(const Rotation rotation, const size_t scale,
+            const size_t sourceWidth, const size_t sourceHeight,
+            const size_t x, const size_t y, size_t& sourceX, size_t& sourceY);
+
+private:
+    /**
+     * @brief  Rotates a point within an area.
+     *
+     * @param rotation  The rotation to apply.
+     *
+     * @param width     The unrotated area width.
+     *
+     * @param height    The unrotated area height.
+     *
+     * @param x         The unrotated x-coordinate.
+     *
+     * @param y         The unrotated y-coordinate.
+     *
+     * @param rotatedX  Used to return the rotated x-coordinate.
+     *
+     * @param rotatedY  Used to return the rotated y-coordinate.
+     */
+    static void rotatePoint(const Rotation rotation, const size_t width,
+            const size_t height, const size_t x, const size_t y,
+            size_t& rotatedX, size_t& rotatedY);
+
+    // Frame buffer size in pixels:
+    size_t physicalWidth;
+    size_t physicalHeight;
+    // Display rotation:
+    Rotation rotation;
+    // Cursor image scale:
+    size_t scale;
+};
@@ -0,0 +1,87 @@
+#include "DrawWorkload.h"
+#include <chrono>
+
+// Describes how the cursor moves along a workload path:
+struct PathOptions
+{
+    // Starting position, as a percentage of the display size:
+    size_t xStartPercent;
+    size_t yStartPercent;
+    // Starting distance moved each frame, in pixels:
+    int xStep;
+    int yStep;
+    // Number of frames drawn between cursor shape changes:
+    size_t framesPerShape;
+    // The cursor moves for the first movingFrames frames out of every
+    // movePeriod frames, and holds still for the rest:
+    size_t movePeriod;
+    size_t movingFrames;
+};
+
+// Options for each DrawWorkload::Path, in order:
+static const PathOptions pathOptions [] =
+{
+    // training:
+    { 0, 0, 3, 2, 997, 64, 48 },
+    // benchmark:
+    { 50, 30, -2, 5, 613, 50, 41 }
+};
+
+// Draws the cursor along the workload path using a cursor backend.
+double DrawWorkload::run(CursorBackend& backend, const size_t frameCount,
+        const bool waitForDisplay, const Path path)
+{
+    const PathOptions& options = pathOptions[static_cast<size_t>(path)];
+    const size_t width = backend.getWidth();
+    const size_t height = backend.getHeight();
+    if (width == 0 || height == 0 || frameCount == 0)
+    {
+        return 0;
+    }
+    // Bounce the cursor between the display edges at mixed speeds, so that
+    // it reaches every edge and corner, and sometimes holds still:
+    size_t x = width * options.xStartPercent / 100;
+    size_t y = height * options.yStartPercent / 100;
+    int xStep = options.xStep;
+    int yStep = options.yStep;
+    size_t shapeIndex = 0;
+    using namespace std::chrono;
+    const steady_clock::time_point startTime = steady_clock::now();
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        if (frame % options.framesPerShape == 0)
+        {
+            backend.setShape(static_cast<CursorAtlas::Shape>(shapeIndex));
+            shapeIndex = (shapeIndex + 1) % CursorAtlas::shapeCount;
+        }
+        if ((frame % options.movePeriod) < options.movingFrames)
+        {
+            const long nextX = static_cast<long>(x) + xStep;
+            const long nextY = static_cast<long>(y) + yStep;
+            if (nextX < 0 || nextX >= static_cast<long>(width))
+            {
+                xStep = -xStep;
+            }
+            else
+            {
+                x = static_cast<size_t>(nextX);
+            }
+            if (nextY < 0 || nextY >= static_cast<long>(height))
+            {
+                yStep = -yStep;
+            }
+            else
+            {
+                y = static_cast<size_t>(nextY);
+            }
+        }
+        backend.drawCursor(x, y);
+        if (waitForDisplay)
+        {
+            backend.waitForDisplay();
+        }
+    }
+    const nanoseconds elapsed = duration_cast<nanoseconds>(
+            steady_clock::now() - startTime);
+    return static_cast<double>(elapsed.count()) / frameCount;
+}
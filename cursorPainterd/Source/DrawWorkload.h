@@ -0,0 +1,57 @@
+/**
+ * @file  DrawWorkload.h
+ *
+ * @brief  A fixed, repeatable sequence of cursor moves and shape changes used
+ *         to measure and train the cursor drawing code.
+ *
+ *  The workload moves the cursor along the same path through the display on
+ * every run, switching cursor shapes at regular intervals, so that results
+ * can be compared between builds. The training path is drawn by the --train
+ * option of both CPICursor and cursorPainterd, and the benchmark path by their
+ * --benchmark option. The benchmark path starts elsewhere and moves at other
+ * speeds, so builds optimized with a training profile aren't measured on the
+ * exact frames they were trained on.
+ */
+
+#pragma once
+#include "CursorBackend.h"
+#include <cstddef>
+
+namespace DrawWorkload
+{
+    // Number of frames drawn by default:
+    static const constexpr size_t defaultFrameCount = 500000;
+
+    /**
+     * @brief  Lists the cursor paths the workload can draw.
+     */
+    enum class Path
+    {
+        // The path drawn to collect optimization profiles:
+        training,
+        // The path drawn to compare build performance:
+        benchmark
+    };
+
+    /**
+     * @brief  Draws the cursor along the workload path using a cursor
+     *         backend.
+     *
+     * @param backend         The backend used to draw the cursor.
+     *
+     * @param frameCount      The number of cursor positions to draw.
+     *
+     * @param waitForDisplay  Whether to wait until each frame is visible
+     *                        before drawing the next, so the result measures
+     *                        latency instead of throughput.
+     *
+     * @param path            The cursor path to draw.
+     *
+     * @return                The average time spent drawing each frame, in
+     *                        nanoseconds.
+     */
+    double run(CursorBackend& backend,
+            const size_t frameCount = defaultFrameCount,
+            const bool waitForDisplay = false,
+            const Path path = Path::training);
+}
@@ -0,0 +1,120 @@
+#include "FrameBufferPainter.h"
+#include "AtlasImage.h"
+#include <fcntl.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Reads the physical display size reported by a frame buffer device, leaving
+// both values at zero if the size is unavailable.
+static void readDisplaySize(const char* frameBufferPath, size_t& widthMM,
+        size_t& heightMM)
+{
+    widthMM = 0;
+    heightMM = 0;
+    const int frameBufferFD = open(frameBufferPath, O_RDONLY | O_CLOEXEC);
+    if (frameBufferFD < 0)
+    {
+        return;
+    }
+    struct fb_var_screeninfo screenInfo;
+    if (ioctl(frameBufferFD, FBIOGET_VSCREENINFO, &screenInfo) == 0)
+    {
+        widthMM = screenInfo.width;
+        heightMM = screenInfo.height;
+    }
+    close(frameBufferFD);
+}
+
+
+// Opens the frame buffer, detects its rotation and pixel density, and loads
+// all cursor images transformed to match.
+FrameBufferPainter::FrameBufferPainter(const char* frameBufferPath) :
+    frameBuffer(frameBufferPath)
+{
+    size_t widthMM, heightMM;
+    readDisplaySize(frameBufferPath, widthMM, heightMM);
+    transform = DisplayTransform::detect(frameBuffer.getWidth(),
+            frameBuffer.getHeight(), widthMM, heightMM);
+    for (size_t i = 0; i < CursorAtlas::shapeCount; i++)
+    {
+        shapePainters[i].reset(new FBPainter::ImagePainter(
+                AtlasImage<0>::createImage(
+                    AtlasVariant::getIndex(i, transform))));
+        shapeBounds[i] = transform.getVariantBounds(CursorAtlas::sprites[i]);
+    }
+    activePainter = shapePainters[0].get();
+    activeSprite = &shapeBounds[0];
+}
+
+
+// Gets the display width in pixels, after rotation.
+size_t FrameBufferPainter::getWidth() const
+{
+    return transform.getWidth();
+}
+
+
+// Gets the display height in pixels, after rotation.
+size_t FrameBufferPainter::getHeight() const
+{
+    return transform.getHeight();
+}
+
+
+// Draws the cursor at a display coordinate, clearing it from its last position
+// if it moved.
+void FrameBufferPainter::drawCursor(const size_t x, const size_t y)
+{
+    if (cursorDrawn && (lastX != x || lastY != y))
+    {
+        activePainter->clearImage(&frameBuffer);
+    }
+    size_t physicalX, physicalY;
+    transform.toPhysical(x, y, physicalX, physicalY);
+    // Images can't extend past the top or left edges, so the hotspot may not
+    // quite reach those edges:
+    const size_t originX = (physicalX > activeSprite->hotspotX)
+            ? (physicalX - activeSprite->hotspotX) : 0;
+    const size_t originY = (physicalY > activeSprite->hotspotY)
+            ? (physicalY - activeSprite->hotspotY) : 0;
+    activePainter->setImageOrigin(originX, originY, &frameBuffer);
+    cursorDrawn = true;
+    lastX = x;
+    lastY = y;
+}
+
+
+// Switches the cursor image, redrawing the cursor at its last position if it
+// was already drawn.
+void FrameBufferPainter::setShape(const CursorAtlas::Shape shape)
+{
+    const size_t shapeIndex = static_cast<size_t>(shape);
+    if (shapeIndex >= CursorAtlas::shapeCount
+            || activePainter == shapePainters[shapeIndex].get())
+    {
+        return;
+    }
+    if (cursorDrawn)
+    {
+        activePainter->clearImage(&frameBuffer);
+    }
+    activePainter = shapePainters[shapeIndex].get();
+    activeSprite = &shapeBounds[shapeIndex];
+    if (cursorDrawn)
+    {
+        cursorDrawn = false;
+        drawCursor(lastX, lastY);
+    }
+}
+
+
+// Clears the cursor from the frame buffer until it is drawn again.
+void FrameBufferPainter::hideCursor()
+{
+    if (cursorDrawn)
+    {
+        activePainter->clearImage(&frameBuffer);
+        cursorDrawn = false;
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ * @file  FrameBufferPainter.h
+ *
+ * @brief  A cursor backend that draws the cursor image to the frame buffer.
+ *
+ *  An FBPainter ImagePainter is created for every cursor atlas shape on
+ * construction, so switching shapes only changes which painter is active.
+ * Each image is rotated and scaled to match the display as it is created.
+ *  FrameBufferPainter is used both by cursorPainterd and by CPICursor's
+ * in-process painter thread, so it must not depend on either program's
+ * messaging or debugging code.
+ */
+
+#pragma once
+#include "CursorBackend.h"
+#include "DisplayTransform.h"
+#include "ImagePainter.h"
+#include "FrameBuffer.h"
+#include <cstddef>
+#include <memory>
+
+class FrameBufferPainter : public CursorBackend
+{
+public:
+    /**
+     * @brief  Opens the frame buffer, detects its rotation and pixel density,
+     *         and loads all cursor images transformed to match.
+     *
+     * @param frameBufferPath  The path to the frame buffer device file.
+     */
+    FrameBufferPainter(const char* frameBufferPath);
+
+    virtual ~FrameBufferPainter() { }
+
+    /**
+     * @brief  Gets the display width in pixels, after rotation.
+     *
+     * @return  The display width.
+     */
+    virtual size_t getWidth() const override;
+
+    /**
+     * @brief  Gets the display height in pixels, after rotation.
+     *
+     * @return  The display height.
+     */
+    virtual size_t getHeight() const override;
+
+    /**
+     * @brief  Draws the cursor at a display coordinate, clearing it from its
+     *         last position if it moved.
+     *
+     * @param x  Screen x-coordinate, measured in pixels.
+     *
+     * @param y  Screen y-coordinate, measured in pixels.
+     */
+    virtual void drawCursor(const size_t x, const size_t y) override;
+
+    /**
+     * @brief  Switches the cursor image, redrawing the cursor at its last
+     *         position if it was already drawn.
+     *
+     * @param shape  The new cursor shape.
+     */
+    virtual void setShape(const CursorAtlas::Shape shape) override;
+
+    /**
+     * @brief  Clears the cursor from the frame buffer until it is drawn
+     *         again.
+     */
+    virtual void hideCursor() override;
+
+private:
+    // Holds the image data for each cursor shape and draws it to the frame
+    // buffer, indexed by shape:
+    std::unique_ptr<FBPainter::ImagePainter>
+            shapePainters [CursorAtlas::shapeCount];
+    // Transformed size and hotspot of each cursor shape:
+    CursorAtlas::Sprite shapeBounds [CursorAtlas::shapeCount];
+    // The painter and image bounds for the current cursor shape:
+    FBPainter::ImagePainter* activePainter;
+    const CursorAtlas::Sprite* activeSprite;
+    // Provides access to the frame buffer.
+    FBPainter::FrameBuffer frameBuffer;
+    // Maps display coordinates to frame buffer coordinates:
+    DisplayTransform transform;
+    // Whether the cursor has been drawn yet:
+    bool cursorDrawn = false;
+    // Last drawn cursor position:
+    size_t lastX = 0;
+    size_t lastY = 0;
+};
@@ -5,9 +5,41 @@
  */
 
 #include "PainterLoop.h"
+#include "RealTime.h"
+#include "Stats.h"
+#include <cstring>
 
 int main(int argc, char** argv)
 {
-    PainterLoop painterLoop;
+    // Lock memory before the frame buffer is mapped, so that the mapping is
+    // locked and populated as it is created:
+    if (RT_LOCK_MEMORY)
+    {
+        RealTime::lockMemory();
+    }
+    RealTime::ThreadConfig threadConfig;
+    threadConfig.policy = RealTime::parsePolicy(RT_POLICY);
+    threadConfig.priority = RT_PRIORITY;
+    threadConfig.cpu = PAINTERD_CPU;
+    RealTime::configureThread(threadConfig, "cursorPainterd");
+    // CPICursor passes --drm to select the DRM cursor plane backend, or --x11
+    // to select the X11 overlay backend. The X display is only accepted later,
+    // in a message from CPICursor:
+    CursorBackend::Type backendType = CursorBackend::Type::frameBuffer;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--drm") == 0)
+        {
+            backendType = CursorBackend::Type::drm;
+        }
+        else if (strcmp(argv[i], "--x11") == 0)
+        {
+            backendType = CursorBackend::Type::x11;
+        }
+    }
+    PainterLoop painterLoop(backendType, threadConfig);
+    Stats::StatsFile statsFile(STATS_PATH, "cursorPainterd");
+    painterLoop.registerStats(statsFile);
+    statsFile.startWriting(STATS_INTERVAL_MS);
     return painterLoop.runLoop();
 }
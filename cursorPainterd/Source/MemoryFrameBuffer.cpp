@@ -0,0 +1,116 @@
+/**
+ * @file  MemoryFrameBuffer.cpp
+ *
+ * @brief  A preloaded library that lets an ordinary file stand in for a frame
+ *         buffer device, so the frame buffer backend can be run without any
+ *         display devices or privileges.
+ *
+ *  FBPainter only draws to frame buffer device files, which it maps into
+ * memory after reading their screen information with ioctl calls. When this
+ * library is loaded with LD_PRELOAD, those screen information requests made on
+ * a regular file describe a packed 32-bit frame buffer instead of failing, so
+ * FrameBufferPainter and FBPainter map the file and draw into it exactly as
+ * they would draw to a display. The frame buffer size is read from the
+ * MEMORY_FB_WIDTH and MEMORY_FB_HEIGHT environment variables, and the file
+ * must be at least width * height * 4 bytes long. All other ioctl calls are
+ * passed on unchanged.
+ *
+ *  The library is only used by the training and benchmark workloads of
+ * profile-guided optimization builds, and is never installed.
+ */
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+// Frame buffer size used if the environment doesn't set one:
+static const constexpr uint32_t defaultWidth = 640;
+static const constexpr uint32_t defaultHeight = 480;
+static const constexpr uint32_t bitsPerPixel = 32;
+
+// Reads a positive frame buffer dimension from the environment.
+static uint32_t readDimension(const char* name, const uint32_t defaultValue)
+{
+    const char* value = getenv(name);
+    if (value == nullptr)
+    {
+        return defaultValue;
+    }
+    const long dimension = strtol(value, nullptr, 10);
+    return (dimension > 0) ? static_cast<uint32_t>(dimension) : defaultValue;
+}
+
+// Describes the memory frame buffer's pixel layout and size.
+static void getVariableInfo(struct fb_var_screeninfo& info)
+{
+    memset(&info, 0, sizeof(info));
+    info.xres = readDimension("MEMORY_FB_WIDTH", defaultWidth);
+    info.yres = readDimension("MEMORY_FB_HEIGHT", defaultHeight);
+    info.xres_virtual = info.xres;
+    info.yres_virtual = info.yres;
+    info.bits_per_pixel = bitsPerPixel;
+    info.red.offset = 16;
+    info.red.length = 8;
+    info.green.offset = 8;
+    info.green.length = 8;
+    info.blue.offset = 0;
+    info.blue.length = 8;
+    info.transp.offset = 24;
+    info.transp.length = 8;
+    // Leave the physical size unknown, so the cursor scale is chosen from the
+    // resolution:
+    info.width = 0;
+    info.height = 0;
+}
+
+// Describes the memory frame buffer's layout in the mapped file.
+static void getFixedInfo(struct fb_fix_screeninfo& info)
+{
+    struct fb_var_screeninfo variableInfo;
+    getVariableInfo(variableInfo);
+    memset(&info, 0, sizeof(info));
+    strncpy(info.id, "Memory FB", sizeof(info.id) - 1);
+    info.line_length = variableInfo.xres * (bitsPerPixel / 8);
+    info.smem_len = info.line_length * variableInfo.yres;
+    info.type = FB_TYPE_PACKED_PIXELS;
+    info.visual = FB_VISUAL_TRUECOLOR;
+}
+
+// Answers frame buffer screen information requests made on regular files, and
+// passes all other requests on to the C library.
+extern "C" int ioctl(int fileDescriptor, unsigned long request, ...)
+{
+    va_list args;
+    va_start(args, request);
+    void* argument = va_arg(args, void*);
+    va_end(args);
+    struct stat fileInfo;
+    const bool isFrameBufferRequest = request == FBIOGET_VSCREENINFO
+            || request == FBIOPUT_VSCREENINFO
+            || request == FBIOGET_FSCREENINFO
+            || request == FBIOPAN_DISPLAY;
+    if (isFrameBufferRequest && fstat(fileDescriptor, &fileInfo) == 0
+            && S_ISREG(fileInfo.st_mode))
+    {
+        if (request == FBIOGET_VSCREENINFO)
+        {
+            getVariableInfo(*static_cast<struct fb_var_screeninfo*>(
+                    argument));
+        }
+        else if (request == FBIOGET_FSCREENINFO)
+        {
+            getFixedInfo(*static_cast<struct fb_fix_screeninfo*>(argument));
+        }
+        // Mode changes and panning are accepted but ignored.
+        return 0;
+    }
+    using IoctlFunction = int (*)(int, unsigned long, ...);
+    static const IoctlFunction nextIoctl = reinterpret_cast<IoctlFunction>(
+            dlsym(RTLD_NEXT, "ioctl"));
+    return nextIoctl(fileDescriptor, request, argument);
+}
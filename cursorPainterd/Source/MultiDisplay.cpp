@@ -0,0 +1,123 @@
+#include "MultiDisplay.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+// Starts a worker thread for each display.
+MultiDisplay::MultiDisplay
+(std::vector<std::unique_ptr<CursorBackend>> backends, const Layout layout,
+        const RealTime::ThreadConfig workerConfig) :
+    layout(layout)
+{
+    for (std::unique_ptr<CursorBackend>& backend : backends)
+    {
+        Display display;
+        display.offsetX = (layout == Layout::combined) ? width : 0;
+        display.width = backend->getWidth();
+        display.height = backend->getHeight();
+        display.showingCursor = false;
+        if (displays.empty() || layout == Layout::combined)
+        {
+            width = display.offsetX + display.width;
+            height = std::max(height, display.height);
+        }
+        const std::string name = "display"
+                + std::to_string(displays.size());
+        display.worker.reset(new PainterThread(std::move(backend),
+                workerConfig, name));
+        displays.push_back(std::move(display));
+    }
+}
+
+
+// Parses a display layout name.
+MultiDisplay::Layout MultiDisplay::parseLayout(const char* layoutName)
+{
+    if (strcmp(layoutName, "combined") == 0)
+    {
+        return Layout::combined;
+    }
+    return Layout::mirrored;
+}
+
+
+// Gets the width of the shared display area in pixels.
+size_t MultiDisplay::getWidth() const
+{
+    return width;
+}
+
+
+// Gets the height of the shared display area in pixels.
+size_t MultiDisplay::getHeight() const
+{
+    return height;
+}
+
+
+// Sends a new cursor position to every display that should show it, and hides
+// the cursor on displays it has left.
+void MultiDisplay::drawCursor(const size_t x, const size_t y)
+{
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+    for (Display& display : displays)
+    {
+        if (display.width == 0 || display.height == 0)
+        {
+            continue;
+        }
+        if (layout == Layout::mirrored)
+        {
+            // Scale the position to match the primary display:
+            display.worker->setCursorPos(x * display.width / width,
+                    y * display.height / height);
+        }
+        else if (x >= display.offsetX && x < display.offsetX + display.width)
+        {
+            // Keep the cursor within shorter displays:
+            display.worker->setCursorPos(x - display.offsetX,
+                    std::min(y, display.height - 1));
+            display.showingCursor = true;
+        }
+        else if (display.showingCursor)
+        {
+            display.worker->hideCursor();
+            display.showingCursor = false;
+        }
+    }
+}
+
+
+// Sends a cursor shape change to every display.
+void MultiDisplay::setShape(const CursorAtlas::Shape shape)
+{
+    for (Display& display : displays)
+    {
+        display.worker->setShape(shape);
+    }
+}
+
+
+// Hides the cursor on every display.
+void MultiDisplay::hideCursor()
+{
+    for (Display& display : displays)
+    {
+        display.worker->hideCursor();
+        display.showingCursor = false;
+    }
+}
+
+
+// Adds the performance counters of each display's worker thread to a stats
+// file.
+void MultiDisplay::registerStats(Stats::StatsFile& statsFile) const
+{
+    for (const Display& display : displays)
+    {
+        display.worker->registerStats(statsFile);
+    }
+}
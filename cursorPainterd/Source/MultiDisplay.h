@@ -0,0 +1,134 @@
+/**
+ * @file  MultiDisplay.h
+ *
+ * @brief  A cursor backend that shows the cursor on several displays at once,
+ *         drawing to each display from its own worker thread.
+ *
+ *  Displays may either mirror the first display, or be combined into a
+ * single wide display area, arranged from left to right in the order they
+ * were added. Each display keeps its own resolution, pixel format, and
+ * rotation. Cursor updates are passed to the worker threads without waiting
+ * for any drawing to finish, so a slow display skips the positions it can't
+ * keep up with instead of delaying the others.
+ */
+
+#pragma once
+#include "CursorBackend.h"
+#include "PainterThread.h"
+#include "RealTime.h"
+#include <memory>
+#include <vector>
+
+class MultiDisplay : public CursorBackend
+{
+public:
+    /**
+     * @brief  Lists the ways the displays may share cursor coordinates.
+     */
+    enum class Layout
+    {
+        // Every display shows the cursor at the same relative position:
+        mirrored,
+        // Displays are placed side by side, and the cursor moves between
+        // them:
+        combined
+    };
+
+    /**
+     * @brief  Starts a worker thread for each display.
+     *
+     * @param displays      The backends used to draw to each display. The
+     *                      first display is the primary display.
+     *
+     * @param layout        How cursor coordinates are shared between
+     *                      displays.
+     *
+     * @param workerConfig  Scheduling options to apply to each worker thread.
+     */
+    MultiDisplay(std::vector<std::unique_ptr<CursorBackend>> displays,
+            const Layout layout, const RealTime::ThreadConfig workerConfig);
+
+    /**
+     * @brief  Stops all worker threads on destruction.
+     */
+    virtual ~MultiDisplay() { }
+
+    /**
+     * @brief  Parses a display layout name.
+     *
+     * @param layoutName  Either "mirrored" or "combined".
+     *
+     * @return            The matching layout, or Layout::mirrored if the name
+     *                    is not recognized.
+     */
+    static Layout parseLayout(const char* layoutName);
+
+    /**
+     * @brief  Gets the width of the shared display area in pixels.
+     *
+     * @return  The primary display width when mirrored, or the sum of all
+     *          display widths when combined.
+     */
+    virtual size_t getWidth() const override;
+
+    /**
+     * @brief  Gets the height of the shared display area in pixels.
+     *
+     * @return  The primary display height when mirrored, or the greatest
+     *          display height when combined.
+     */
+    virtual size_t getHeight() const override;
+
+    /**
+     * @brief  Sends a new cursor position to every display that should show
+     *         it, and hides the cursor on displays it has left.
+     *
+     * @param x  Shared display area x-coordinate, measured in pixels.
+     *
+     * @param y  Shared display area y-coordinate, measured in pixels.
+     */
+    virtual void drawCursor(const size_t x, const size_t y) override;
+
+    /**
+     * @brief  Sends a cursor shape change to every display.
+     *
+     * @param shape  The new cursor shape.
+     */
+    virtual void setShape(const CursorAtlas::Shape shape) override;
+
+    /**
+     * @brief  Hides the cursor on every display.
+     */
+    virtual void hideCursor() override;
+
+    /**
+     * @brief  Adds the performance counters of each display's worker thread
+     *         to a stats file.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    virtual void registerStats(Stats::StatsFile& statsFile) const override;
+
+private:
+    /**
+     * @brief  Holds a single display and its worker thread.
+     */
+    struct Display
+    {
+        // Draws to the display:
+        std::unique_ptr<PainterThread> worker;
+        // The display's position within the combined display area:
+        size_t offsetX;
+        // The display size in pixels:
+        size_t width;
+        size_t height;
+        // Whether the display was last told to show the cursor:
+        bool showingCursor;
+    };
+
+    const Layout layout;
+    std::vector<Display> displays;
+    // Shared display area size:
+    size_t width = 0;
+    size_t height = 0;
+};
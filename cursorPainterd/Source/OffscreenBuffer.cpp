@@ -0,0 +1,128 @@
+#include "OffscreenBuffer.h"
+#include <algorithm>
+
+// Allocates the pixel buffer and fills it with a fixed background pattern on
+// construction.
+OffscreenBuffer::OffscreenBuffer(const size_t width, const size_t height) :
+    width(width), height(height), pixels(width * height),
+    activeSprite(&CursorAtlas::sprites[0])
+{
+    for (size_t y = 0; y < height; y++)
+    {
+        for (size_t x = 0; x < width; x++)
+        {
+            pixels[y * width + x] = 0xff000000 | ((x & 0xff) << 16)
+                    | ((y & 0xff) << 8) | ((x ^ y) & 0xff);
+        }
+    }
+    size_t maxSpriteSize = 0;
+    for (const CursorAtlas::Sprite& sprite : CursorAtlas::sprites)
+    {
+        maxSpriteSize = std::max(maxSpriteSize, sprite.width * sprite.height);
+    }
+    savedPixels.resize(maxSpriteSize);
+}
+
+
+// Gets the buffer width in pixels.
+size_t OffscreenBuffer::getWidth() const
+{
+    return width;
+}
+
+
+// Gets the buffer height in pixels.
+size_t OffscreenBuffer::getHeight() const
+{
+    return height;
+}
+
+
+// Draws the cursor into the buffer, restoring the pixels it previously
+// covered.
+void OffscreenBuffer::drawCursor(const size_t x, const size_t y)
+{
+    restoreBackground();
+    const CursorAtlas::Sprite& sprite = *activeSprite;
+    drawnX = std::min((x > sprite.hotspotX) ? (x - sprite.hotspotX) : 0,
+            width);
+    drawnY = std::min((y > sprite.hotspotY) ? (y - sprite.hotspotY) : 0,
+            height);
+    drawnWidth = std::min(sprite.width, width - drawnX);
+    drawnHeight = std::min(sprite.height, height - drawnY);
+    for (size_t row = 0; row < drawnHeight; row++)
+    {
+        uint32_t* bufferRow = &pixels[(drawnY + row) * width + drawnX];
+        const uint32_t* spriteRow = &sprite.pixels[row * sprite.width];
+        std::copy(bufferRow, bufferRow + drawnWidth,
+                &savedPixels[row * drawnWidth]);
+        for (size_t column = 0; column < drawnWidth; column++)
+        {
+            const uint32_t color = spriteRow[column];
+            const uint32_t alpha = color >> 24;
+            if (alpha == 0)
+            {
+                continue;
+            }
+            if (alpha == 255)
+            {
+                bufferRow[column] = color;
+                continue;
+            }
+            const uint32_t background = bufferRow[column];
+            uint32_t blended = 0xff000000;
+            for (int shift = 0; shift < 24; shift += 8)
+            {
+                const uint32_t front = (color >> shift) & 0xff;
+                const uint32_t back = (background >> shift) & 0xff;
+                blended |= ((front * alpha + back * (255 - alpha)) / 255)
+                        << shift;
+            }
+            bufferRow[column] = blended;
+        }
+    }
+    cursorDrawn = true;
+    lastX = x;
+    lastY = y;
+}
+
+
+// Switches the cursor image, redrawing the cursor at its last position if it
+// was already drawn.
+void OffscreenBuffer::setShape(const CursorAtlas::Shape shape)
+{
+    const size_t shapeIndex = static_cast<size_t>(shape);
+    if (shapeIndex >= CursorAtlas::shapeCount)
+    {
+        return;
+    }
+    activeSprite = &CursorAtlas::sprites[shapeIndex];
+    if (cursorDrawn)
+    {
+        drawCursor(lastX, lastY);
+    }
+}
+
+
+// Restores the pixels under the cursor until it is drawn again.
+void OffscreenBuffer::hideCursor()
+{
+    restoreBackground();
+}
+
+
+// Restores the buffer pixels saved when the cursor was last drawn.
+void OffscreenBuffer::restoreBackground()
+{
+    if (! cursorDrawn)
+    {
+        return;
+    }
+    for (size_t row = 0; row < drawnHeight; row++)
+    {
+        std::copy(&savedPixels[row * drawnWidth],
+                &savedPixels[row * drawnWidth] + drawnWidth,
+                &pixels[(drawnY + row) * width + drawnX]);
+    }
+    cursorDrawn = false;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file  OffscreenBuffer.h
+ *
+ * @brief  A cursor backend that draws the cursor into a pixel buffer in
+ *         memory instead of onto the display.
+ *
+ *  OffscreenBuffer needs no devices or privileges, so it is used to check the
+ * drawing pipeline for heap allocations with CPICursor --alloc-check and
+ * cursorPainterdWorkloads --alloc-check.
+ * Like the frame buffer backend, it saves the pixels under the cursor and
+ * restores them when the cursor moves, and it alpha-blends the cursor image
+ * over the buffer contents.
+ */
+
+#pragma once
+#include "CursorBackend.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class OffscreenBuffer : public CursorBackend
+{
+public:
+    // Default buffer size, matching the GameShell display:
+    static const constexpr size_t defaultWidth = 320;
+    static const constexpr size_t defaultHeight = 240;
+
+    /**
+     * @brief  Allocates the pixel buffer and fills it with a fixed background
+     *         pattern on construction.
+     *
+     * @param width   The buffer width in pixels.
+     *
+     * @param height  The buffer height in pixels.
+     */
+    OffscreenBuffer(const size_t width = defaultWidth,
+            const size_t height = defaultHeight);
+
+    virtual ~OffscreenBuffer() { }
+
+    /**
+     * @brief  Gets the buffer width in pixels.
+     *
+     * @return  The buffer width.
+     */
+    virtual size_t getWidth() const override;
+
+    /**
+     * @brief  Gets the buffer height in pixels.
+     *
+     * @return  The buffer height.
+     */
+    virtual size_t getHeight() const override;
+
+    /**
+     * @brief  Draws the cursor into the buffer, restoring the pixels it
+     *         previously covered.
+     *
+     * @param x  Buffer x-coordinate, measured in pixels.
+     *
+     * @param y  Buffer y-coordinate, measured in pixels.
+     */
+    virtual void drawCursor(const size_t x, const size_t y) override;
+
+    /**
+     * @brief  Switches the cursor image, redrawing the cursor at its last
+     *         position if it was already drawn.
+     *
+     * @param shape  The new cursor shape.
+     */
+    virtual void setShape(const CursorAtlas::Shape shape) override;
+
+    /**
+     * @brief  Restores the pixels under the cursor until it is drawn
+     *         again.
+     */
+    virtual void hideCursor() override;
+
+private:
+    /**
+     * @brief  Restores the buffer pixels saved when the cursor was last
+     *         drawn.
+     */
+    void restoreBackground();
+
+    // Buffer size in pixels:
+    const size_t width;
+    const size_t height;
+    // Buffer contents, as 32-bit ARGB pixels:
+    std::vector<uint32_t> pixels;
+    // Buffer pixels covered by the cursor, saved before it was drawn:
+    std::vector<uint32_t> savedPixels;
+    // Image data for the current cursor shape:
+    const CursorAtlas::Sprite* activeSprite;
+    // Whether the cursor is currently drawn:
+    bool cursorDrawn = false;
+    // Last requested cursor position:
+    size_t lastX = 0;
+    size_t lastY = 0;
+    // Buffer area covered by the drawn cursor:
+    size_t drawnX = 0;
+    size_t drawnY = 0;
+    size_t drawnWidth = 0;
+    size_t drawnHeight = 0;
+};
@@ -0,0 +1,31 @@
+/**
+ * @file  PainterCommand.h
+ *
+ * @brief  Defines the messages CPICursor sends to cursorPainterd.
+ *
+ *  Every message holds two size_t values. Usually these are the x and y
+ * coordinates where the cursor should be drawn. When the first value is
+ * setShape, the second value is instead the index of the CursorAtlas::Shape
+ * the cursor should switch to. When the first value is setDisplay, the second
+ * value is the number of the local X display the X11 backend should use.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace PainterCommand
+{
+    // Size in bytes of every message sent to cursorPainterd:
+    static const constexpr size_t messageSize = sizeof(size_t) * 2;
+
+    // Marks a message as a shape change instead of a cursor position:
+    static const constexpr size_t setShape = SIZE_MAX;
+
+    // Marks a message as the X display selection instead of a cursor position.
+    // The X11 backend isn't started until this message is received:
+    static const constexpr size_t setDisplay = SIZE_MAX - 1;
+
+    // Largest X display number that may be sent with setDisplay:
+    static const constexpr size_t maxDisplayNumber = 65535;
+}
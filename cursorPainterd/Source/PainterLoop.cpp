@@ -1,8 +1,10 @@
 #include "PainterLoop.h"
-#include "Cursor.h"
-#include "CodeImage.h"
+#include "PainterCommand.h"
+#include "AllocGuard.h"
 #include "Debug.h"
 #include <ctime>
+#include <string>
+#include <utility>
 
 #ifdef DF_DEBUG
 static const constexpr char* messagePrefix = "PainterLoop::";
@@ -10,17 +12,62 @@ static const constexpr char* messagePrefix = "PainterLoop::";
 
 static const constexpr int maxFPS = 60;
 static const std::chrono::nanoseconds loopDuration(1000000000 / maxFPS);
+// Number of frames between debug jitter reports:
+static const constexpr int jitterReportFrequency = maxFPS * 60;
 
-// Initializes cursor image data on construction, and sends the display
-// resolution back to CPICursor.
-PainterLoop::PainterLoop() : DaemonFramework::DaemonLoop(sizeof(size_t) * 2),
-    imagePainter(new FBPainter::CodeImage<FBPainter::Cursor>),
-    frameBuffer(FB_PATH),
-    lastDrawTime(std::chrono::high_resolution_clock::now()) 
+// Initializes the cursor backend on construction, and sends the display
+// resolution back to CPICursor. The X11 backend is instead started once
+// CPICursor sends the X display to use.
+PainterLoop::PainterLoop(const CursorBackend::Type backendType,
+        const RealTime::ThreadConfig threadConfig) :
+    DaemonFramework::DaemonLoop(PainterCommand::messageSize),
+    lastDrawTime(std::chrono::high_resolution_clock::now()),
+    backendType(backendType), threadConfig(threadConfig)
 {
+    if (backendType != CursorBackend::Type::x11)
+    {
+        startBackend(nullptr);
+    }
+}
+
+
+// Draws with an existing cursor backend, without sending the display
+// resolution to CPICursor.
+PainterLoop::PainterLoop(std::unique_ptr<CursorBackend> backend) :
+    DaemonFramework::DaemonLoop(PainterCommand::messageSize),
+    lastDrawTime(std::chrono::high_resolution_clock::now()),
+    backendType(CursorBackend::Type::offscreen), threadConfig(),
+    backend(std::move(backend)) { }
+
+
+// Adds the performance counters of the PainterLoop and its cursor backend to a
+// stats file.
+void PainterLoop::registerStats(Stats::StatsFile& statsFile) const
+{
+    statsFile.addCounter("frames_drawn", framesDrawn);
+    statsFile.addCounter("frames_skipped", framesSkipped);
+    statsFile.addCounter("queue_overflows", queueOverflows);
+    statsFile.addCounter("invalid_messages", invalidMessages);
+    statsFile.addCounter("bytes_received", bytesReceived);
+    statsFile.addCounter("shape_changes", shapeChanges);
+    statsFile.addCounter("draw_time_total_ns", drawTimeTotal);
+    statsFile.addCounter("draw_time_max_ns", drawTimeMax);
+    statsFile.addJitter("loop_jitter", loopJitter);
+    if (backend != nullptr)
+    {
+        backend->registerStats(statsFile);
+    }
+}
+
+
+// Creates the cursor backend, and sends the display resolution back to
+// CPICursor.
+void PainterLoop::startBackend(const char* displayName)
+{
+    backend = CursorBackend::create(backendType, threadConfig, displayName);
     static size_t resolution [2];
-    resolution[0] = frameBuffer.getWidth();
-    resolution[1] = frameBuffer.getHeight();
+    resolution[0] = backend->getWidth();
+    resolution[1] = backend->getHeight();
     DF_DBG(messagePrefix << __func__ << ": sending display resolution "
             << resolution[0] << " x " << resolution[1] << " (size "
             << sizeof(resolution) << ") to CPICursor.");
@@ -33,6 +80,7 @@ PainterLoop::PainterLoop() : DaemonFramework::DaemonLoop(sizeof(size_t) * 2),
 // cursor no more than once per loop.
 int PainterLoop::loopAction()
 {
+    ALLOC_GUARD_SCOPE
     using namespace std::chrono;
     const time_point<high_resolution_clock, nanoseconds> loopStart 
             = high_resolution_clock::now();
@@ -44,18 +92,42 @@ int PainterLoop::loopAction()
         sleepTimer.tv_sec = 0;
         sleepTimer.tv_nsec = sleepTime.count();
         nanosleep(&sleepTimer, nullptr);
+        loopJitter.addSample(high_resolution_clock::now()
+                - (lastDrawTime + loopDuration));
+        if ((loopJitter.getSampleCount() % jitterReportFrequency) == 0)
+        {
+            DF_DBG(messagePrefix << __func__ << ": Loop jitter mean "
+                    << loopJitter.getMeanNanoseconds() / 1000 << "us, max "
+                    << loopJitter.getMaxNanoseconds() / 1000 << "us");
+        }
     }
     const std::lock_guard<std::mutex> lock(pointLock);
-    if (gotFirstMessage)
+    if (gotFirstMessage && backend != nullptr)
     {
-        DrawPoint& nextPoint = (bufferedPointCount == 0) ? lastDrawn 
-                : pointBuffer[startIndex];
-        if (lastDrawn.x != nextPoint.x || lastDrawn.y != nextPoint.y)
+        if (bufferedPointCount == 0)
+        {
+            framesSkipped.add();
+        }
+        else
+        {
+            framesDrawn.add();
+        }
+        const time_point<high_resolution_clock, nanoseconds> drawStart
+                = high_resolution_clock::now();
+        if (shapeChanged)
         {
-            imagePainter.clearImage(&frameBuffer);
+            backend->setShape(pendingShape);
+            shapeChanged = false;
+            shapeChanges.add();
         }
-        imagePainter.setImageOrigin(nextPoint.x, nextPoint.y, &frameBuffer);
+        DrawPoint& nextPoint = (bufferedPointCount == 0) ? lastDrawn 
+                : pointBuffer[startIndex];
+        backend->drawCursor(nextPoint.x, nextPoint.y);
         lastDrawn = nextPoint;
+        const nanoseconds drawTime = high_resolution_clock::now()
+                - drawStart;
+        drawTimeTotal.add(drawTime.count());
+        drawTimeMax.recordMax(drawTime.count());
         if (bufferedPointCount > 0)
         {
             bufferedPointCount--;
@@ -71,18 +143,58 @@ int PainterLoop::loopAction()
 }
 
 
-// Reads cursor drawing coordinates sent from CPICursor, and buffers them until
-// loopAction can handle them.
+// Reads cursor drawing coordinates and shape changes sent from CPICursor, and
+// buffers them until loopAction can handle them.
 void PainterLoop::handleParentMessage
 (const unsigned char* messageData, const size_t messageSize)
 {
-    if (messageSize != (sizeof(size_t) * 2))
+    ALLOC_GUARD_SCOPE
+    bytesReceived.add(messageSize);
+    if (messageSize != PainterCommand::messageSize)
     {
+        invalidMessages.add();
         DF_DBG(messagePrefix << __func__ << ": Invalid message size "
                 << messageSize);
         return;
     }
     const size_t* pointMessage = reinterpret_cast<const size_t*>(messageData);
+    if (pointMessage[0] == PainterCommand::setShape)
+    {
+        if (pointMessage[1] >= CursorAtlas::shapeCount)
+        {
+            invalidMessages.add();
+            DF_DBG(messagePrefix << __func__ << ": Invalid cursor shape "
+                    << pointMessage[1]);
+            return;
+        }
+        DF_DBG_V(messagePrefix << __func__ << ": Requesting cursor shape "
+                << pointMessage[1]);
+        const std::lock_guard<std::mutex> lock(pointLock);
+        pendingShape = static_cast<CursorAtlas::Shape>(pointMessage[1]);
+        shapeChanged = true;
+        return;
+    }
+    if (pointMessage[0] == PainterCommand::setDisplay)
+    {
+        const std::lock_guard<std::mutex> lock(pointLock);
+        if (backend != nullptr
+                || pointMessage[1] > PainterCommand::maxDisplayNumber)
+        {
+            invalidMessages.add();
+            DF_DBG(messagePrefix << __func__ << ": Ignoring X display "
+                    << pointMessage[1]);
+            return;
+        }
+        // Starting the backend only happens once, and isn't part of the
+        // steady state:
+        ALLOC_GUARD_ALLOW
+        const std::string displayName
+                = ":" + std::to_string(pointMessage[1]);
+        DF_DBG(messagePrefix << __func__ << ": Using X display "
+                << displayName);
+        startBackend(displayName.c_str());
+        return;
+    }
     DrawPoint point = { pointMessage[0], pointMessage[1] };
     DF_DBG_V(messagePrefix << __func__ << ": Requesting cursor draw at ("
             << point.x << ", " << point.y << ")");
@@ -91,6 +203,7 @@ void PainterLoop::handleParentMessage
     if (bufferedPointCount == pointBufSize)
     {
         // Buffer is full, cut the oldest point and push the index forward.
+        queueOverflows.add();
         pointBuffer[startIndex] = point;
         DF_DBG_V("Request buffered at " << startIndex);
         startIndex++;
@@ -7,23 +7,55 @@
 
 #pragma once
 #include "DaemonLoop.h"
-#include "ImagePainter.h"
-#include "FrameBuffer.h"
+#include "CursorBackend.h"
+#include "CursorAtlas.h"
+#include "RealTime.h"
+#include "Stats.h"
 #include <mutex>
 #include <cstddef>
 #include <chrono>
+#include <memory>
+
+class PainterWorkload;
 
 class PainterLoop : public DaemonFramework::DaemonLoop
 {
 public:
+    friend PainterWorkload;
+
     /**
-     * @brief  Initializes cursor image data on construction, and sends the
-     *         display resolution back to CPICursor.
+     * @brief  Initializes the cursor backend on construction, and sends the
+     *         display resolution back to CPICursor. The X11 backend is instead
+     *         started once CPICursor sends the X display to use.
+     *
+     * @param backendType   The type of cursor backend to use.
+     *
+     * @param threadConfig  Scheduling options to apply to any worker threads
+     *                      the cursor backend uses.
      */
-    PainterLoop();
+    PainterLoop(const CursorBackend::Type backendType,
+            const RealTime::ThreadConfig threadConfig);
+
+    /**
+     * @brief  Draws with an existing cursor backend, without sending the
+     *         display resolution to CPICursor. This lets workloads run the
+     *         loop's message handling and drawing outside of the daemon.
+     *
+     * @param backend  The cursor backend to draw with.
+     */
+    PainterLoop(std::unique_ptr<CursorBackend> backend);
 
     virtual ~PainterLoop() { }
 
+    /**
+     * @brief  Adds the performance counters of the PainterLoop and its
+     *         cursor backend to a stats file. The counters of a backend that
+     *         hasn't started yet are left out.
+     *
+     * @param statsFile  The stats file that will publish the counters.
+     */
+    void registerStats(Stats::StatsFile& statsFile) const;
+
 private:
     /**
      * @brief  Periodically checks for pending cursor drawing commands,
@@ -35,18 +67,29 @@ private:
     virtual int loopAction() final override;
 
     /**
-     * @brief  Reads cursor drawing coordinates sent from CPICursor, and
-     *         buffers them until loopAction can handle them.
+     * @brief  Reads cursor drawing coordinates and shape changes sent from
+     *         CPICursor, and buffers them until loopAction can handle them.
      *
      * @param messageData  Message data, which should consist of two size_t
-     *                     values representing display pixel coordinates.
+     *                     values representing display pixel coordinates, or
+     *                     a shape change or display selection as described in
+     *                     PainterCommand.h.
      *
      * @param messageSize  The size of the message. If this does not equal
-     *                     2 * sizeof(size_t), the message is invalid.
+     *                     PainterCommand::messageSize, the message is invalid.
      */
     virtual void handleParentMessage(const unsigned char* messageData,
             const size_t messageSize) override;
 
+    /**
+     * @brief  Creates the cursor backend, and sends the display resolution
+     *         back to CPICursor.
+     *
+     * @param displayName  The X display used by the X11 backend, or nullptr
+     *                     for other backends.
+     */
+    void startBackend(const char* displayName);
+
     /**
      * @brief  Stores a screen coordinate in pixels.
      */
@@ -60,6 +103,25 @@ private:
     // Last draw time:
     std::chrono::time_point<std::chrono::high_resolution_clock,
             std::chrono::nanoseconds> lastDrawTime;
+    // Measures how late the loop wakes up after sleeping between frames:
+    RealTime::JitterStats loopJitter;
+
+    // Performance counters:
+    // Frames where a new cursor position was drawn:
+    Stats::Counter framesDrawn;
+    // Frames where no new cursor position was pending:
+    Stats::Counter framesSkipped;
+    // Pending points dropped because the point buffer was full:
+    Stats::Counter queueOverflows;
+    // Messages ignored because they were invalid:
+    Stats::Counter invalidMessages;
+    // Bytes read from CPICursor's pipe:
+    Stats::Counter bytesReceived;
+    // Cursor shape changes applied:
+    Stats::Counter shapeChanges;
+    // Total and maximum time spent drawing a single frame:
+    Stats::Counter drawTimeTotal;
+    Stats::Counter drawTimeMax;
 
     // Managing pending cursor draw commands:
     // Whether the first draw command has been sent:
@@ -72,13 +134,19 @@ private:
     size_t bufferedPointCount = 0;
     // Sliding index tracking the front of the buffer queue:
     size_t startIndex = 0;
+    // The most recently requested cursor shape:
+    CursorAtlas::Shape pendingShape = CursorAtlas::Shape(0);
+    // Whether the requested shape still needs to be applied:
+    bool shapeChanged = false;
     // Prevents simultaneous buffer updates:
     std::mutex pointLock;
 
-    // Handling cursor drawing operations:
-    // Holds cursor image data and draws it to the frame buffer.
-    FBPainter::ImagePainter imagePainter;
-    // Provides access to the frame buffer.
-    FBPainter::FrameBuffer frameBuffer;
+    // The type of cursor backend to use:
+    const CursorBackend::Type backendType;
+    // Scheduling options for the cursor backend's worker threads:
+    const RealTime::ThreadConfig threadConfig;
+    // Puts the cursor on the display, or is null until the X11 backend gets
+    // its display:
+    std::unique_ptr<CursorBackend> backend;
 
 };
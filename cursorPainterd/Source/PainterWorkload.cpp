@@ -0,0 +1,134 @@
+#include "PainterWorkload.h"
+#include "PainterLoop.h"
+#include "PainterCommand.h"
+#include "OffscreenBuffer.h"
+#include "AllocGuard.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+// Number of frames in the generated message trace, two seconds of drawing at
+// the loop's frame rate:
+static const constexpr size_t traceFrameCount = 120;
+// Number of trace frames replayed before counting allocations:
+static const constexpr size_t allocWarmupFrameCount = 60;
+// Seed used to generate the message trace:
+static const constexpr uint32_t traceSeed = 0x50415444;
+// Trace frames between bursts of cursor moves that overflow the point buffer:
+static const constexpr size_t burstInterval = 40;
+// Trace frames between groups of invalid messages:
+static const constexpr size_t invalidInterval = 20;
+// Largest distance the cursor moves in each direction between messages:
+static const constexpr uint32_t maxStep = 4;
+
+// Generates the message trace on construction.
+PainterWorkload::PainterWorkload()
+{
+    // A simple linear congruential generator keeps the trace identical
+    // across runs, builds, and standard library versions:
+    uint32_t randomState = traceSeed;
+    const auto nextRandom = [&randomState]()
+    {
+        randomState = randomState * 1664525 + 1013904223;
+        return randomState >> 8;
+    };
+    const size_t width = OffscreenBuffer::defaultWidth;
+    const size_t height = OffscreenBuffer::defaultHeight;
+    size_t x = width / 2;
+    size_t y = height / 2;
+    for (size_t frame = 0; frame < traceFrameCount; frame++)
+    {
+        const size_t startCount = messageSizes.size();
+        const size_t moveCount = ((frame % burstInterval) == 0)
+                ? PainterLoop::pointBufSize + 2 : nextRandom() % 2;
+        for (size_t i = 0; i < moveCount; i++)
+        {
+            x = (x + width + (nextRandom() % (maxStep * 2 + 1)) - maxStep)
+                    % width;
+            y = (y + height + (nextRandom() % (maxStep * 2 + 1)) - maxStep)
+                    % height;
+            addMessage(x, y);
+        }
+        if ((nextRandom() % 20) == 0)
+        {
+            addMessage(PainterCommand::setShape,
+                    nextRandom() % CursorAtlas::shapeCount);
+        }
+        if ((frame % invalidInterval) == (invalidInterval / 2))
+        {
+            // An unknown shape, a display change after the backend started,
+            // and a message cut short:
+            addMessage(PainterCommand::setShape, CursorAtlas::shapeCount);
+            addMessage(PainterCommand::setDisplay, 0);
+            const size_t shortSize = PainterCommand::messageSize / 2;
+            messageData.insert(messageData.end(), shortSize, 0);
+            messageSizes.push_back(shortSize);
+        }
+        frameSizes.push_back(messageSizes.size() - startCount);
+    }
+}
+
+
+// Replays the message trace through a PainterLoop drawing into an offscreen
+// buffer, checking that no heap memory is allocated after the first frames
+// warm it up.
+int PainterWorkload::checkAllocations()
+{
+#if ! ALLOC_CHECK
+    fprintf(stderr, "PainterWorkload: Allocations are only counted in "
+            "ALLOC_CHECK=1 builds.\n");
+    return 1;
+#else
+    PainterLoop painterLoop(std::unique_ptr<CursorBackend>(
+            new OffscreenBuffer));
+    replay(painterLoop, allocWarmupFrameCount);
+    // Guard scopes abort on allocations within the steady-state code paths,
+    // and the allocation count also catches any made outside of them:
+    const uint64_t startCount = AllocGuard::getAllocationCount();
+    replay(painterLoop, frameSizes.size());
+    const uint64_t allocations = AllocGuard::getAllocationCount()
+            - startCount;
+    printf("alloc_check.painterd_allocations %llu\n",
+            static_cast<unsigned long long>(allocations));
+    return (allocations == 0) ? 0 : 1;
+#endif
+}
+
+
+// Adds a message holding two size_t values to the trace.
+void PainterWorkload::addMessage(const size_t first, const size_t second)
+{
+    const size_t message [2] = { first, second };
+    const unsigned char* messageBytes
+            = reinterpret_cast<const unsigned char*>(message);
+    messageData.insert(messageData.end(), messageBytes,
+            messageBytes + PainterCommand::messageSize);
+    messageSizes.push_back(PainterCommand::messageSize);
+}
+
+
+// Sends trace messages to a PainterLoop, running one loop action after each
+// trace frame's messages.
+void PainterWorkload::replay
+(PainterLoop& painterLoop, const size_t frameCount)
+{
+    size_t messageIndex = 0;
+    size_t dataOffset = 0;
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        const size_t traceFrame = frame % frameSizes.size();
+        if (traceFrame == 0)
+        {
+            messageIndex = 0;
+            dataOffset = 0;
+        }
+        for (size_t i = 0; i < frameSizes[traceFrame]; i++)
+        {
+            painterLoop.handleParentMessage(&messageData[dataOffset],
+                    messageSizes[messageIndex]);
+            dataOffset += messageSizes[messageIndex];
+            messageIndex++;
+        }
+        painterLoop.loopAction();
+    }
+}
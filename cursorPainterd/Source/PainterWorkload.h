@@ -0,0 +1,66 @@
+/**
+ * @file  PainterWorkload.h
+ *
+ * @brief  Replays a fixed trace of CPICursor's messages through
+ *         cursorPainterd's message handling and drawing loop.
+ *
+ *  cursorPainterdWorkloads --alloc-check feeds the trace through a PainterLoop
+ * drawing into an offscreen buffer, reading each message from one block of
+ * bytes as it would arrive from CPICursor's pipe. The trace is the same on
+ * every run, and mixes cursor moves with bursts that overflow the point
+ * buffer, shape changes, and invalid messages. Once the loop has warmed up,
+ * the check fails if any heap memory is allocated.
+ */
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+class PainterLoop;
+
+class PainterWorkload
+{
+public:
+    /**
+     * @brief  Generates the message trace on construction.
+     */
+    PainterWorkload();
+
+    /**
+     * @brief  Replays the message trace through a PainterLoop drawing into an
+     *         offscreen buffer, checking that no heap memory is allocated
+     *         after the first frames warm it up. This requires an
+     *         ALLOC_CHECK=1 build.
+     *
+     * @return  Zero if nothing was allocated, or one if memory was allocated
+     *          or allocations can't be counted in this build.
+     */
+    int checkAllocations();
+
+private:
+    /**
+     * @brief  Adds a message holding two size_t values to the trace.
+     *
+     * @param first   The first message value.
+     *
+     * @param second  The second message value.
+     */
+    void addMessage(const size_t first, const size_t second);
+
+    /**
+     * @brief  Sends trace messages to a PainterLoop, running one loop action
+     *         after each trace frame's messages.
+     *
+     * @param painterLoop  The loop receiving messages.
+     *
+     * @param frameCount   The number of trace frames to send.
+     */
+    void replay(PainterLoop& painterLoop, const size_t frameCount);
+
+    // All message bytes in the trace, in order:
+    std::vector<unsigned char> messageData;
+    // The size of each message in the trace:
+    std::vector<size_t> messageSizes;
+    // The number of messages in each trace frame:
+    std::vector<size_t> frameSizes;
+};
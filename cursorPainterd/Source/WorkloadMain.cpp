@@ -0,0 +1,91 @@
+/**
+ * @file  cursorPainterd/Source/WorkloadMain.cpp
+ *
+ * @brief  The main build file for cursorPainterdWorkloads, which runs
+ *         cursorPainterd's drawing code on fixed workloads to train and
+ *         measure optimized builds, to measure X11 backend latency, and to
+ *         check its message handling for heap allocations.
+ *
+ *  cursorPainterdWorkloads is built from the same objects as cursorPainterd,
+ * so profiles recorded while it runs also apply to the daemon. It is never
+ * installed: the daemon runs with extra privileges, and must only ever be
+ * controlled by CPICursor.
+ */
+
+#include "FrameBufferPainter.h"
+#include "DrawWorkload.h"
+#include "PainterWorkload.h"
+#if X11_BACKEND
+#include "X11Cursor.h"
+#endif
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+// Number of frames drawn when measuring X11 latency:
+static const constexpr size_t latencyFrameCount = 5000;
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        // With --alloc-check, replay a fixed trace of CPICursor's messages and
+        // fail if it allocates heap memory after warming up:
+        if (strcmp(argv[i], "--alloc-check") == 0)
+        {
+            PainterWorkload painterWorkload;
+            return painterWorkload.checkAllocations();
+        }
+        // With --x11-latency, measure how long the X server set in DISPLAY
+        // takes to show each cursor move:
+        if (strcmp(argv[i], "--x11-latency") == 0)
+        {
+#if X11_BACKEND
+            X11Cursor x11Cursor;
+            if (! x11Cursor.isReady())
+            {
+                return 1;
+            }
+            printf("latency.x11_frame_ns %.1f\n", DrawWorkload::run(
+                    x11Cursor, latencyFrameCount, true));
+            return 0;
+#else
+            fprintf(stderr, "cursorPainterdWorkloads: Built without "
+                    "X11_BACKEND.\n");
+            return 1;
+#endif
+        }
+        // With --train or --benchmark, draw the fixed training or benchmark
+        // path on the frame buffer that follows the option:
+        const bool benchmark = (strcmp(argv[i], "--benchmark") == 0);
+        if (benchmark || strcmp(argv[i], "--train") == 0)
+        {
+            const char* frameBufferPath = (i + 1 < argc)
+                    ? argv[i + 1] : nullptr;
+            if (frameBufferPath == nullptr
+                    || access(frameBufferPath, R_OK | W_OK) != 0)
+            {
+                fprintf(stderr, "cursorPainterdWorkloads: %s needs a "
+                        "writable frame buffer path.\n", argv[i]);
+                return 1;
+            }
+            FrameBufferPainter frameBuffer(frameBufferPath);
+            if (frameBuffer.getWidth() == 0)
+            {
+                return 1;
+            }
+            printf("%s.painterd_draw_frame_ns %.1f\n",
+                    benchmark ? "bench" : "train",
+                    DrawWorkload::run(frameBuffer,
+                        DrawWorkload::defaultFrameCount, false, benchmark
+                        ? DrawWorkload::Path::benchmark
+                        : DrawWorkload::Path::training));
+            return 0;
+        }
+    }
+    fprintf(stderr, "Usage: cursorPainterdWorkloads --train <frame buffer>\n"
+            "       cursorPainterdWorkloads --benchmark <frame buffer>\n"
+            "       cursorPainterdWorkloads --x11-latency\n"
+            "       cursorPainterdWorkloads --alloc-check\n");
+    return 1;
+}
@@ -0,0 +1,412 @@
+#include "X11Cursor.h"
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xfixes.h>
+#include <X11/extensions/shape.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <vector>
+
+// Cursor image pixels with alpha values below this are left out of the window
+// shape:
+static const constexpr uint32_t minOpaqueAlpha = 128;
+
+// Converts an 8-bit color component to a TrueColor channel value.
+static unsigned long packChannel(const uint32_t component,
+        const unsigned long mask)
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    int shift = 0;
+    while (((mask >> shift) & 1) == 0)
+    {
+        shift++;
+    }
+    const unsigned long maxValue = mask >> shift;
+    return ((component * maxValue / 255) << shift) & mask;
+}
+
+// Set if the X server reported an error while attaching a shared memory
+// segment:
+static bool shmAttachFailed = false;
+
+// Records X errors caused by attaching a shared memory segment, instead of
+// letting the default error handler exit.
+static int handleShmAttachError(Display* display, XErrorEvent* error)
+{
+    (void) display;
+    (void) error;
+    shmAttachFailed = true;
+    return 0;
+}
+
+
+// Connects to the X server, creates the overlay window, and uploads all cursor
+// images.
+X11Cursor::X11Cursor(const char* displayName)
+{
+    display = XOpenDisplay(displayName);
+    if (display == nullptr)
+    {
+        fprintf(stderr, "X11Cursor: Failed to open X display \"%s\".\n",
+                XDisplayName(displayName));
+        return;
+    }
+    screen = DefaultScreen(display);
+    visual = DefaultVisual(display, screen);
+    depth = DefaultDepth(display, screen);
+    if (visual->c_class != TrueColor)
+    {
+        fprintf(stderr, "X11Cursor: The default visual isn't TrueColor.\n");
+        return;
+    }
+    int eventBase, errorBase;
+    if (! XShapeQueryExtension(display, &eventBase, &errorBase))
+    {
+        fprintf(stderr, "X11Cursor: The SHAPE extension is missing.\n");
+        return;
+    }
+    useSharedMemory = XShmQueryExtension(display);
+    ready = createWindow() && uploadShapes();
+    if (ready)
+    {
+        setShape(CursorAtlas::Shape(0));
+    }
+}
+
+
+// Destroys the overlay window and its pixmaps, and closes the server
+// connection on destruction.
+X11Cursor::~X11Cursor()
+{
+    if (display == nullptr)
+    {
+        return;
+    }
+    for (size_t i = 0; i < CursorAtlas::shapeCount; i++)
+    {
+        if (shapePixmaps[i] != 0)
+        {
+            XFreePixmap(display, shapePixmaps[i]);
+        }
+        if (shapeMasks[i] != 0)
+        {
+            XFreePixmap(display, shapeMasks[i]);
+        }
+    }
+    if (graphicsContext != nullptr)
+    {
+        XFreeGC(display, graphicsContext);
+    }
+    if (window != 0)
+    {
+        XDestroyWindow(display, window);
+    }
+    XCloseDisplay(display);
+}
+
+
+// Checks if the overlay window was successfully set up.
+bool X11Cursor::isReady() const
+{
+    return ready;
+}
+
+
+// Gets the X screen width in pixels.
+size_t X11Cursor::getWidth() const
+{
+    return (display == nullptr) ? 0 : DisplayWidth(display, screen);
+}
+
+
+// Gets the X screen height in pixels.
+size_t X11Cursor::getHeight() const
+{
+    return (display == nullptr) ? 0 : DisplayHeight(display, screen);
+}
+
+
+// Moves the overlay window so its hotspot is at a screen coordinate, showing
+// it if it was hidden.
+void X11Cursor::drawCursor(const size_t x, const size_t y)
+{
+    if (! ready || (mapped && lastX == (long) x && lastY == (long) y))
+    {
+        return;
+    }
+    XMoveWindow(display, window, (long) x - (long) activeSprite->hotspotX,
+            (long) y - (long) activeSprite->hotspotY);
+    if (! mapped)
+    {
+        XMapRaised(display, window);
+        mapped = true;
+    }
+    lastX = x;
+    lastY = y;
+    handleEvents();
+}
+
+
+// Switches the overlay window to a different cursor shape's pixmap and shape
+// mask.
+void X11Cursor::setShape(const CursorAtlas::Shape shape)
+{
+    const size_t shapeIndex = static_cast<size_t>(shape);
+    if (! ready || shapeIndex >= CursorAtlas::shapeCount
+            || activeSprite == &CursorAtlas::sprites[shapeIndex])
+    {
+        return;
+    }
+    const CursorAtlas::Sprite& sprite = CursorAtlas::sprites[shapeIndex];
+    // Keep the hotspot in place while the window changes size:
+    const long hotspotX = (lastX == LONG_MIN) ? 0 : lastX;
+    const long hotspotY = (lastY == LONG_MIN) ? 0 : lastY;
+    XMoveResizeWindow(display, window, hotspotX - (long) sprite.hotspotX,
+            hotspotY - (long) sprite.hotspotY, sprite.width, sprite.height);
+    XSetWindowBackgroundPixmap(display, window, shapePixmaps[shapeIndex]);
+    XShapeCombineMask(display, window, ShapeBounding, 0, 0,
+            shapeMasks[shapeIndex], ShapeSet);
+    XClearWindow(display, window);
+    activeSprite = &sprite;
+    handleEvents();
+}
+
+
+// Unmaps the overlay window until the cursor is drawn again.
+void X11Cursor::hideCursor()
+{
+    if (! ready || ! mapped)
+    {
+        return;
+    }
+    XUnmapWindow(display, window);
+    mapped = false;
+    handleEvents();
+}
+
+
+// Waits until the X server has processed every request sent so far.
+void X11Cursor::waitForDisplay()
+{
+    if (display != nullptr)
+    {
+        XSync(display, False);
+    }
+}
+
+
+// Creates the overlay window, and lets pointer input pass through it.
+bool X11Cursor::createWindow()
+{
+    int eventBase, errorBase;
+    int majorVersion = 0;
+    int minorVersion = 0;
+    if (! XFixesQueryExtension(display, &eventBase, &errorBase)
+            || ! XFixesQueryVersion(display, &majorVersion, &minorVersion)
+            || majorVersion < 2)
+    {
+        fprintf(stderr, "X11Cursor: XFixes 2.0 or newer is missing.\n");
+        return false;
+    }
+    XSetWindowAttributes attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    // Keep window managers from decorating or moving the window:
+    attributes.override_redirect = True;
+    attributes.background_pixmap = None;
+    // Let the server restore whatever the cursor covered without asking
+    // other windows to redraw:
+    attributes.save_under = True;
+    attributes.event_mask = VisibilityChangeMask;
+    const CursorAtlas::Sprite& sprite = CursorAtlas::sprites[0];
+    window = XCreateWindow(display, RootWindow(display, screen), 0, 0,
+            sprite.width, sprite.height, 0, depth, InputOutput, visual,
+            CWOverrideRedirect | CWBackPixmap | CWSaveUnder | CWEventMask,
+            &attributes);
+    if (window == 0)
+    {
+        fprintf(stderr, "X11Cursor: Failed to create the overlay window.\n");
+        return false;
+    }
+    XStoreName(display, window, "CPICursor");
+    // An empty input shape sends all pointer input to the windows below:
+    XserverRegion emptyRegion = XFixesCreateRegion(display, nullptr, 0);
+    XFixesSetWindowShapeRegion(display, window, ShapeInput, 0, 0,
+            emptyRegion);
+    XFixesDestroyRegion(display, emptyRegion);
+    graphicsContext = XCreateGC(display, window, 0, nullptr);
+    return graphicsContext != nullptr;
+}
+
+
+// Creates a pixmap and shape mask for every cursor shape.
+bool X11Cursor::uploadShapes()
+{
+    for (size_t i = 0; i < CursorAtlas::shapeCount; i++)
+    {
+        const CursorAtlas::Sprite& sprite = CursorAtlas::sprites[i];
+        shapePixmaps[i] = XCreatePixmap(display, window, sprite.width,
+                sprite.height, depth);
+        if (shapePixmaps[i] == 0 || ! uploadImage(shapePixmaps[i], sprite))
+        {
+            fprintf(stderr, "X11Cursor: Failed to upload cursor image.\n");
+            return false;
+        }
+        // Shape masks use one bit per pixel, with each row padded to a
+        // whole byte:
+        const size_t rowBytes = (sprite.width + 7) / 8;
+        std::vector<char> maskBits(rowBytes * sprite.height, 0);
+        for (size_t y = 0; y < sprite.height; y++)
+        {
+            for (size_t x = 0; x < sprite.width; x++)
+            {
+                if ((sprite.pixels[y * sprite.width + x] >> 24)
+                        >= minOpaqueAlpha)
+                {
+                    maskBits[y * rowBytes + x / 8] |= (1 << (x % 8));
+                }
+            }
+        }
+        shapeMasks[i] = XCreateBitmapFromData(display, window,
+                maskBits.data(), sprite.width, sprite.height);
+        if (shapeMasks[i] == 0)
+        {
+            fprintf(stderr, "X11Cursor: Failed to create cursor mask.\n");
+            return false;
+        }
+    }
+    XSync(display, False);
+    return true;
+}
+
+
+// Copies a cursor image into a pixmap, converting it to the window's pixel
+// format.
+bool X11Cursor::uploadImage(const Pixmap pixmap,
+        const CursorAtlas::Sprite& sprite)
+{
+    XShmSegmentInfo segmentInfo;
+    memset(&segmentInfo, 0, sizeof(segmentInfo));
+    XImage* image = nullptr;
+    if (useSharedMemory)
+    {
+        image = XShmCreateImage(display, visual, depth, ZPixmap, nullptr,
+                &segmentInfo, sprite.width, sprite.height);
+        if (image != nullptr)
+        {
+            segmentInfo.shmid = shmget(IPC_PRIVATE,
+                    image->bytes_per_line * image->height, IPC_CREAT | 0600);
+            if (segmentInfo.shmid < 0)
+            {
+                XDestroyImage(image);
+                image = nullptr;
+            }
+        }
+        if (image != nullptr)
+        {
+            segmentInfo.shmaddr = static_cast<char*>(
+                    shmat(segmentInfo.shmid, nullptr, 0));
+            // Remove the segment now, so it is freed once both processes
+            // detach from it:
+            shmctl(segmentInfo.shmid, IPC_RMID, nullptr);
+            if (segmentInfo.shmaddr == reinterpret_cast<char*>(-1))
+            {
+                XDestroyImage(image);
+                image = nullptr;
+            }
+            else
+            {
+                image->data = segmentInfo.shmaddr;
+                segmentInfo.readOnly = True;
+                // The server may still refuse the segment, for example if it
+                // can't access this process's IPC namespace. Catch the error
+                // instead of exiting, and send images over the connection:
+                XSync(display, False);
+                shmAttachFailed = false;
+                const XErrorHandler lastHandler
+                        = XSetErrorHandler(handleShmAttachError);
+                const Status attached = XShmAttach(display, &segmentInfo);
+                XSync(display, False);
+                XSetErrorHandler(lastHandler);
+                if (! attached || shmAttachFailed)
+                {
+                    fprintf(stderr, "X11Cursor: MIT-SHM attach failed, "
+                            "sending images without shared memory.\n");
+                    XDestroyImage(image);
+                    shmdt(segmentInfo.shmaddr);
+                    image = nullptr;
+                    useSharedMemory = false;
+                }
+            }
+        }
+    }
+    const bool sharedImage = (image != nullptr);
+    if (! sharedImage)
+    {
+        // Fall back to sending the image over the connection:
+        image = XCreateImage(display, visual, depth, ZPixmap, 0, nullptr,
+                sprite.width, sprite.height, 32, 0);
+        if (image == nullptr)
+        {
+            return false;
+        }
+        image->data = static_cast<char*>(
+                malloc(image->bytes_per_line * image->height));
+        if (image->data == nullptr)
+        {
+            XDestroyImage(image);
+            return false;
+        }
+    }
+    for (size_t y = 0; y < sprite.height; y++)
+    {
+        for (size_t x = 0; x < sprite.width; x++)
+        {
+            const uint32_t color = sprite.pixels[y * sprite.width + x];
+            XPutPixel(image, x, y,
+                    packChannel((color >> 16) & 0xff, visual->red_mask)
+                    | packChannel((color >> 8) & 0xff, visual->green_mask)
+                    | packChannel(color & 0xff, visual->blue_mask));
+        }
+    }
+    if (sharedImage)
+    {
+        XShmPutImage(display, pixmap, graphicsContext, image, 0, 0, 0, 0,
+                sprite.width, sprite.height, False);
+        // The segment must stay attached until the server has copied it:
+        XSync(display, False);
+        XShmDetach(display, &segmentInfo);
+        XDestroyImage(image);
+        shmdt(segmentInfo.shmaddr);
+    }
+    else
+    {
+        XPutImage(display, pixmap, graphicsContext, image, 0, 0, 0, 0,
+                sprite.width, sprite.height);
+        XDestroyImage(image);
+    }
+    return true;
+}
+
+
+// Sends pending requests, and raises the overlay window if another window has
+// covered it.
+void X11Cursor::handleEvents()
+{
+    // XPending flushes the request buffer before checking for events:
+    while (XPending(display) > 0)
+    {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.type == VisibilityNotify
+                && event.xvisibility.state != VisibilityUnobscured)
+        {
+            XRaiseWindow(display, window);
+        }
+    }
+}
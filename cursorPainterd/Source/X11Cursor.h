@@ -0,0 +1,157 @@
+/**
+ * @file  X11Cursor.h
+ *
+ * @brief  A cursor backend that shows the cursor within an X11 session, using
+ *         a small shaped overlay window.
+ *
+ *  Drawing directly to the frame buffer doesn't work while some X servers are
+ * running, so this backend lets the X server draw the cursor instead. Every
+ * cursor shape is copied into its own server-side pixmap once on
+ * construction, using MIT-SHM when it is available. The overlay window uses
+ * the active shape's pixmap as its background and a shape mask built from
+ * its transparency, so the server redraws it without any help. Pointer input
+ * passes through the window, as XFixes clears its input shape.
+ *
+ *  After setup, each cursor move is a single XMoveWindow request, and no
+ * pixel data is sent to the server. The window is raised again whenever
+ * another window covers it.
+ */
+
+#pragma once
+#include "CursorBackend.h"
+#include "CursorAtlas.h"
+#include <X11/Xlib.h>
+#include <climits>
+
+class X11Cursor : public CursorBackend
+{
+public:
+    /**
+     * @brief  Connects to the X server, creates the overlay window, and
+     *         uploads all cursor images.
+     *
+     * @param displayName  The X display to use, or nullptr to use the
+     *                     DISPLAY environment variable.
+     */
+    X11Cursor(const char* displayName = nullptr);
+
+    /**
+     * @brief  Destroys the overlay window and its pixmaps, and closes the
+     *         server connection on destruction.
+     */
+    virtual ~X11Cursor();
+
+    /**
+     * @brief  Checks if the overlay window was successfully set up.
+     *
+     * @return  Whether the cursor can be shown with this backend.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief  Gets the X screen width in pixels.
+     *
+     * @return  The screen width.
+     */
+    virtual size_t getWidth() const override;
+
+    /**
+     * @brief  Gets the X screen height in pixels.
+     *
+     * @return  The screen height.
+     */
+    virtual size_t getHeight() const override;
+
+    /**
+     * @brief  Moves the overlay window so its hotspot is at a screen
+     *         coordinate, showing it if it was hidden.
+     *
+     * @param x  Screen x-coordinate, measured in pixels.
+     *
+     * @param y  Screen y-coordinate, measured in pixels.
+     */
+    virtual void drawCursor(const size_t x, const size_t y) override;
+
+    /**
+     * @brief  Switches the overlay window to a different cursor shape's
+     *         pixmap and shape mask.
+     *
+     * @param shape  The new cursor shape.
+     */
+    virtual void setShape(const CursorAtlas::Shape shape) override;
+
+    /**
+     * @brief  Unmaps the overlay window until the cursor is drawn again.
+     */
+    virtual void hideCursor() override;
+
+    /**
+     * @brief  Waits until the X server has processed every request sent so
+     *         far.
+     */
+    virtual void waitForDisplay() override;
+
+private:
+    /**
+     * @brief  Creates the overlay window, and lets pointer input pass through
+     *         it.
+     *
+     * @return  Whether the window was created.
+     */
+    bool createWindow();
+
+    /**
+     * @brief  Creates a pixmap and shape mask for every cursor shape.
+     *
+     * @return  Whether all pixmaps were created.
+     */
+    bool uploadShapes();
+
+    /**
+     * @brief  Copies a cursor image into a pixmap, converting it to the
+     *         window's pixel format.
+     *
+     *  MIT-SHM is used when available. If the X server refuses to attach a
+     * shared memory segment, the image is sent over the connection instead,
+     * and shared memory isn't used again.
+     *
+     * @param pixmap  The pixmap receiving the image.
+     *
+     * @param sprite  The cursor image to copy.
+     *
+     * @return        Whether the image was copied.
+     */
+    bool uploadImage(const Pixmap pixmap, const CursorAtlas::Sprite& sprite);
+
+    /**
+     * @brief  Sends pending requests, and raises the overlay window if
+     *         another window has covered it.
+     */
+    void handleEvents();
+
+    // X server connection:
+    Display* display = nullptr;
+    // Screen and visual used by the overlay window:
+    int screen = 0;
+    Visual* visual = nullptr;
+    int depth = 0;
+    // The overlay window:
+    Window window = 0;
+    // Copies pixel data into pixmaps:
+    GC graphicsContext = nullptr;
+    // Cursor image pixmaps and shape masks, indexed by shape:
+    Pixmap shapePixmaps [CursorAtlas::shapeCount] = {0};
+    Pixmap shapeMasks [CursorAtlas::shapeCount] = {0};
+    // Image data for the shape currently shown, set once the window is
+    // ready:
+    const CursorAtlas::Sprite* activeSprite = nullptr;
+    // Whether MIT-SHM can be used to upload images:
+    bool useSharedMemory = false;
+    // Whether the window was set up successfully:
+    bool ready = false;
+    // Whether the window is currently mapped:
+    bool mapped = false;
+    // Last cursor hotspot position, used to skip redundant moves:
+    long lastX = LONG_MIN;
+    long lastY = LONG_MIN;
+};
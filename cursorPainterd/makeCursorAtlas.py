@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""Packs the cursor images listed in a cursors.txt file into CursorAtlas.h and
+CursorAtlas.cpp.
+
+Usage: makeCursorAtlas.py <cursor image directory> <output directory>
+
+Each non-comment line in cursors.txt names one cursor shape and the position
+of its hotspot, the pixel that marks the actual cursor position:
+
+    <shape name> <hotspot x> <hotspot y>
+
+The shape's image is read from <shape name>.png in the same directory. Shapes
+are numbered in the order they are listed, so the first shape is the default.
+All images are converted to 32-bit ARGB pixels and packed into a single array,
+so cursorPainterd never has to decode or convert images at runtime.
+
+Only the standard library is used, so PNG decoding is limited to
+non-interlaced images with 8 bits per channel.
+"""
+
+import os
+import struct
+import sys
+import zlib
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+
+# Bytes per pixel for each supported PNG color type:
+CHANNEL_COUNTS = {
+    0: 1,  # Grayscale
+    2: 3,  # RGB
+    3: 1,  # Palette indices
+    4: 2,  # Grayscale and alpha
+    6: 4   # RGBA
+}
+
+
+def fail(message):
+    """Prints an error message and stops the build."""
+    sys.stderr.write('makeCursorAtlas.py: ' + message + '\n')
+    sys.exit(1)
+
+
+def paeth(left, up, upLeft):
+    """Returns the PNG Paeth predictor for a single byte."""
+    estimate = left + up - upLeft
+    leftDistance = abs(estimate - left)
+    upDistance = abs(estimate - up)
+    upLeftDistance = abs(estimate - upLeft)
+    if leftDistance <= upDistance and leftDistance <= upLeftDistance:
+        return left
+    if upDistance <= upLeftDistance:
+        return up
+    return upLeft
+
+
+def unfilter(data, width, height, pixelSize):
+    """Reverses PNG scanline filtering, returning a list of row bytes."""
+    rowSize = width * pixelSize
+    rows = []
+    previous = bytearray(rowSize)
+    offset = 0
+    for _ in range(height):
+        filterType = data[offset]
+        row = bytearray(data[offset + 1:offset + 1 + rowSize])
+        offset += rowSize + 1
+        for i in range(rowSize):
+            left = row[i - pixelSize] if i >= pixelSize else 0
+            up = previous[i]
+            upLeft = previous[i - pixelSize] if i >= pixelSize else 0
+            if filterType == 1:
+                row[i] = (row[i] + left) & 0xff
+            elif filterType == 2:
+                row[i] = (row[i] + up) & 0xff
+            elif filterType == 3:
+                row[i] = (row[i] + ((left + up) >> 1)) & 0xff
+            elif filterType == 4:
+                row[i] = (row[i] + paeth(left, up, upLeft)) & 0xff
+            elif filterType != 0:
+                fail('invalid PNG filter type %d' % filterType)
+        rows.append(row)
+        previous = row
+    return rows
+
+
+def readPNG(path):
+    """Reads a PNG image, returning its width, height, and a list of
+    (red, green, blue, alpha) tuples."""
+    with open(path, 'rb') as imageFile:
+        data = imageFile.read()
+    if not data.startswith(PNG_SIGNATURE):
+        fail(path + ' is not a PNG image')
+    offset = len(PNG_SIGNATURE)
+    header = None
+    palette = []
+    transparency = b''
+    compressed = b''
+    while offset < len(data):
+        length, chunkType = struct.unpack('>I4s', data[offset:offset + 8])
+        chunk = data[offset + 8:offset + 8 + length]
+        offset += length + 12
+        if chunkType == b'IHDR':
+            header = struct.unpack('>IIBBBBB', chunk)
+        elif chunkType == b'PLTE':
+            palette = [tuple(chunk[i:i + 3]) for i in range(0, length, 3)]
+        elif chunkType == b'tRNS':
+            transparency = chunk
+        elif chunkType == b'IDAT':
+            compressed += chunk
+        elif chunkType == b'IEND':
+            break
+    if header is None:
+        fail(path + ' has no PNG header')
+    width, height, bitDepth, colorType, _, _, interlace = header
+    if bitDepth != 8 or colorType not in CHANNEL_COUNTS or interlace != 0:
+        fail(path + ': only non-interlaced 8-bit PNG images are supported')
+    channels = CHANNEL_COUNTS[colorType]
+    rows = unfilter(zlib.decompress(compressed), width, height, channels)
+    pixels = []
+    for row in rows:
+        for x in range(width):
+            values = row[x * channels:(x + 1) * channels]
+            if colorType == 0:
+                pixels.append((values[0], values[0], values[0], 255))
+            elif colorType == 2:
+                pixels.append((values[0], values[1], values[2], 255))
+            elif colorType == 3:
+                index = values[0]
+                if index >= len(palette):
+                    fail(path + ': invalid palette index')
+                alpha = transparency[index] if index < len(transparency) \
+                        else 255
+                pixels.append(palette[index] + (alpha,))
+            elif colorType == 4:
+                pixels.append((values[0], values[0], values[0], values[1]))
+            else:
+                pixels.append(tuple(values))
+    return width, height, pixels
+
+
+def readShapeList(imageDir):
+    """Reads cursors.txt, returning a list of (name, hotspotX, hotspotY)
+    tuples."""
+    shapes = []
+    listPath = os.path.join(imageDir, 'cursors.txt')
+    with open(listPath) as listFile:
+        for lineNum, line in enumerate(listFile, 1):
+            line = line.split('#')[0].strip()
+            if not line:
+                continue
+            fields = line.split()
+            if len(fields) != 3 or not fields[0].isidentifier():
+                fail('%s:%d: expected "<name> <hotspot x> <hotspot y>"'
+                     % (listPath, lineNum))
+            shapes.append((fields[0], int(fields[1]), int(fields[2])))
+    if not shapes:
+        fail(listPath + ' lists no cursor shapes')
+    return shapes
+
+
+def argb(pixel):
+    """Packs an RGBA tuple into a 32-bit ARGB value."""
+    red, green, blue, alpha = pixel
+    if alpha == 0:
+        return 0
+    return (alpha << 24) | (red << 16) | (green << 8) | blue
+
+
+def formatArray(values):
+    """Formats a list of numbers as the contents of a C++ array."""
+    return ', '.join(str(value) for value in values)
+
+
+HEADER_TEMPLATE = '''/**
+ * @file  CursorAtlas.h
+ *
+ * @brief  Cursor images generated from the PNG files in cursorPainterd/Cursors.
+ *
+ *  This file is generated by makeCursorAtlas.py, and should not be edited.
+ * All images are packed into a single array of 32-bit ARGB pixels when the
+ * project is built, so no image decoding or conversion happens at runtime.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace CursorAtlas
+{{
+    /**
+     * @brief  Lists all cursor shapes, in the order they appear in
+     *         cursors.txt.
+     */
+    enum class Shape
+    {{
+{enumValues}
+    }};
+
+    // Number of cursor shapes:
+    static const constexpr size_t shapeCount = {shapeCount};
+
+    // Image width of each shape in pixels, indexed by shape:
+    static const constexpr size_t widths [shapeCount] = {{ {widths} }};
+
+    // Image height of each shape in pixels, indexed by shape:
+    static const constexpr size_t heights [shapeCount] = {{ {heights} }};
+
+    // Number of distinct colors in each shape's image, indexed by shape:
+    static const constexpr size_t colorCounts [shapeCount] = {{ {colors} }};
+
+    /**
+     * @brief  Describes a single cursor image within the atlas.
+     */
+    struct Sprite
+    {{
+        // Image size in pixels:
+        size_t width;
+        size_t height;
+        // The image pixel that marks the cursor position:
+        size_t hotspotX;
+        size_t hotspotY;
+        // Image rows, as 32-bit ARGB pixels that are not premultiplied:
+        const uint32_t* pixels;
+    }};
+
+    // All cursor images, indexed by shape:
+    extern const Sprite sprites [shapeCount];
+
+    /**
+     * @brief  Gets the image used for a cursor shape.
+     *
+     * @param shape  A cursor shape.
+     *
+     * @return       The shape's image data.
+     */
+    inline const Sprite& getSprite(const Shape shape)
+    {{
+        return sprites[static_cast<size_t>(shape)];
+    }}
+}}
+'''
+
+SOURCE_TEMPLATE = '''#include "CursorAtlas.h"
+
+// All cursor images, packed one after another as rows of ARGB pixels:
+static const uint32_t atlasPixels [] =
+{{
+{pixelRows}
+}};
+
+// All cursor images, indexed by shape:
+const CursorAtlas::Sprite CursorAtlas::sprites [shapeCount] =
+{{
+{spriteEntries}
+}};
+'''
+
+
+def main():
+    if len(sys.argv) != 3:
+        fail('usage: makeCursorAtlas.py <image directory> <output directory>')
+    imageDir, outputDir = sys.argv[1:]
+    shapes = readShapeList(imageDir)
+    widths, heights, colorCounts = [], [], []
+    pixelRows, spriteEntries = [], []
+    atlasOffset = 0
+    for name, hotspotX, hotspotY in shapes:
+        width, height, pixels = readPNG(os.path.join(imageDir, name + '.png'))
+        if hotspotX >= width or hotspotY >= height:
+            fail('%s hotspot (%d, %d) is outside its %dx%d image'
+                 % (name, hotspotX, hotspotY, width, height))
+        values = [argb(pixel) for pixel in pixels]
+        widths.append(width)
+        heights.append(height)
+        colorCounts.append(len(set(values)))
+        pixelRows.append('    // %s: %d x %d' % (name, width, height))
+        for start in range(0, len(values), 6):
+            pixelRows.append('    ' + ', '.join('0x%08x' % value
+                    for value in values[start:start + 6]) + ',')
+        spriteEntries.append('    {{ {}, {}, {}, {}, atlasPixels + {} }},'
+                .format(width, height, hotspotX, hotspotY, atlasOffset))
+        atlasOffset += width * height
+
+    enumValues = ',\n'.join('        ' + name for name, _, _ in shapes)
+    header = HEADER_TEMPLATE.format(enumValues=enumValues,
+            shapeCount=len(shapes), widths=formatArray(widths),
+            heights=formatArray(heights), colors=formatArray(colorCounts))
+    source = SOURCE_TEMPLATE.format(pixelRows='\n'.join(pixelRows),
+            spriteEntries='\n'.join(spriteEntries))
+    os.makedirs(outputDir, exist_ok=True)
+    with open(os.path.join(outputDir, 'CursorAtlas.h'), 'w') as headerFile:
+        headerFile.write(header)
+    with open(os.path.join(outputDir, 'CursorAtlas.cpp'), 'w') as sourceFile:
+        sourceFile.write(source)
+
+
+if __name__ == '__main__':
+    main()